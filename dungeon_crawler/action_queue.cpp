@@ -0,0 +1,66 @@
+#include "action_queue.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void ResetActionQueue(ActionQueue &queue, int lookahead, int skipDepth) {
+  queue = ActionQueue{};
+  queue.lookahead = std::max(0, std::min(kActionQueueCapacity, lookahead));
+  queue.skipDepth = std::max(0, skipDepth);
+}
+
+static bool HasAction(const InputAction &action) {
+  return action.dx != 0 || action.dy != 0 || action.wait ||
+         action.usePotion || action.restart || action.confirm;
+}
+
+static void Resolve(ActionQueue &queue, double pressed, double now) {
+  double latency = now - pressed;
+  queue.resolved++;
+  queue.latencySum += latency;
+  queue.latencyMax = std::max(queue.latencyMax, latency);
+}
+
+void PushAction(ActionQueue &queue, const InputAction &pressed) {
+  if (!HasAction(pressed)) return;
+  if ((int)queue.count >= std::max(1, queue.lookahead)) {
+    queue.dropped++;
+    return;
+  }
+  uint32_t tail = (queue.head + queue.count) % kActionQueueCapacity;
+  queue.entries[tail] = QueuedAction{pressed, queue.clock};
+  queue.count++;
+}
+
+InputAction PopAction(ActionQueue &queue, const Game &game, float dt) {
+  double now = queue.clock;
+  queue.clock += dt;
+  if (queue.count == 0) return InputAction{};
+  bool ready = AcceptsAction(game, dt);
+  if (!ready && queue.lookahead == 0) {
+    queue.dropped += queue.count;
+    queue.count = 0;
+    return InputAction{};
+  }
+  bool skip = !ready && queue.skipDepth > 0 &&
+              (int)queue.count >= queue.skipDepth;
+  if (!ready && !skip) return InputAction{};
+
+  QueuedAction next = queue.entries[queue.head];
+  queue.head = (queue.head + 1) % kActionQueueCapacity;
+  queue.count--;
+  Resolve(queue, next.pressed, now);
+  if (skip) {
+    next.action.skipAnim = true;
+    queue.skipped++;
+  }
+  return next.action;
+}
+
+void PrintLatencyStats(const ActionQueue &queue) {
+  double avg = queue.resolved > 0 ? queue.latencySum / queue.resolved : 0.0;
+  std::printf("actions   %u resolved, %u dropped, %u skips\n",
+              queue.resolved, queue.dropped, queue.skipped);
+  std::printf("latency   avg %.1f ms, max %.1f ms\n", avg * 1000.0,
+              queue.latencyMax * 1000.0);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "game.h"
+#include "input.h"
+
+#include <cstdint>
+
+struct QueuedAction {
+  InputAction action;
+  double pressed;
+};
+
+const int kActionQueueCapacity = 8;
+
+struct ActionQueue {
+  QueuedAction entries[kActionQueueCapacity];
+  uint32_t head;
+  uint32_t count;
+  int lookahead;
+  int skipDepth;
+  double clock;
+  uint32_t resolved;
+  uint32_t dropped;
+  uint32_t skipped;
+  double latencySum;
+  double latencyMax;
+};
+
+void ResetActionQueue(ActionQueue &queue, int lookahead, int skipDepth);
+void PushAction(ActionQueue &queue, const InputAction &pressed);
+InputAction PopAction(ActionQueue &queue, const Game &game, float dt);
+void PrintLatencyStats(const ActionQueue &queue);
@@ -0,0 +1,336 @@
+#include "game.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct BalanceConfig {
+  GameConfig game;
+  long long firstSeed;
+  int games;
+  int threads;
+  int maxTurns;
+  int potionPct;
+  int explorePct;
+};
+
+struct BotScratch {
+  std::vector<int32_t> parent;
+  std::vector<int32_t> queue;
+};
+
+struct RunStats {
+  int floor;
+  int turns;
+  int gold;
+  int potionsUsed;
+  int killer;
+  bool stalled;
+};
+
+const int kMaxFloorBucket = 16;
+const int kMaxIdleFrames = 256;
+
+struct WorkerTotals {
+  long long games;
+  long long floors;
+  long long turns;
+  long long gold;
+  long long potionsUsed;
+  long long deaths[2];
+  long long survived;
+  long long stalled;
+  long long floorHistogram[kMaxFloorBucket];
+  int deepest;
+};
+
+static bool IsFrontier(const Dungeon &dungeon, int x, int y) {
+  static const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (const auto &dir : dirs) {
+    int nx = x + dir[0];
+    int ny = y + dir[1];
+    if (InBounds(dungeon, nx, ny) && !TestBit(dungeon.seen, nx, ny)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static InputAction StepToward(const Game &game, const BotScratch &scratch,
+                              int goal) {
+  const Dungeon &dungeon = game.dungeon;
+  int start = TileIndex(dungeon, game.player.actor.cell.x,
+                        game.player.actor.cell.y);
+  int idx = goal;
+  while (scratch.parent[idx] != start) idx = scratch.parent[idx];
+  InputAction action = {};
+  action.dx = idx % dungeon.width - game.player.actor.cell.x;
+  action.dy = idx / dungeon.width - game.player.actor.cell.y;
+  return action;
+}
+
+static InputAction BotAction(const Game &game, const BalanceConfig &config,
+                             BotScratch &scratch) {
+  InputAction action = {};
+  if (game.mode != GameMode::Playing) {
+    action.confirm = true;
+    return action;
+  }
+  const Player &player = game.player;
+  if (player.potions > 0 && player.hp < player.maxHp &&
+      player.hp * 100 < player.maxHp * config.potionPct) {
+    action.usePotion = true;
+    return action;
+  }
+
+  const Dungeon &dungeon = game.dungeon;
+  GridPos p = player.actor.cell;
+  static const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (const auto &dir : dirs) {
+    int nx = p.x + dir[0];
+    int ny = p.y + dir[1];
+    if (!InBounds(dungeon, nx, ny)) continue;
+    if (game.occupancy.enemies[TileIndex(dungeon, nx, ny)] != 0) {
+      action.dx = dir[0];
+      action.dy = dir[1];
+      return action;
+    }
+  }
+
+  int size = dungeon.width * dungeon.height;
+  scratch.parent.assign(size, -1);
+  scratch.queue.clear();
+  int start = TileIndex(dungeon, p.x, p.y);
+  int exitIdx = TileIndex(dungeon, dungeon.exit.x, dungeon.exit.y);
+  scratch.parent[start] = start;
+  scratch.queue.push_back(start);
+  bool wantExit = game.exploredPct >= config.explorePct;
+  int interesting = -1;
+  for (size_t head = 0; head < scratch.queue.size(); head++) {
+    int idx = scratch.queue[head];
+    int x = idx % dungeon.width;
+    int y = idx / dungeon.width;
+    if (idx != start && interesting < 0 &&
+        (HasTileFlag(dungeon, x, y, kTileItem) ||
+         IsFrontier(dungeon, x, y))) {
+      interesting = idx;
+      if (!wantExit) break;
+    }
+    for (const auto &dir : dirs) {
+      int nx = x + dir[0];
+      int ny = y + dir[1];
+      if (!IsWalkable(dungeon, nx, ny) || !TestBit(dungeon.seen, nx, ny)) {
+        continue;
+      }
+      int next = TileIndex(dungeon, nx, ny);
+      if (scratch.parent[next] >= 0 || game.occupancy.enemies[next] != 0) {
+        continue;
+      }
+      scratch.parent[next] = idx;
+      scratch.queue.push_back(next);
+    }
+  }
+
+  bool exitKnown = scratch.parent[exitIdx] >= 0 && exitIdx != start;
+  if ((wantExit || interesting < 0) && exitKnown) {
+    return StepToward(game, scratch, exitIdx);
+  }
+  if (interesting >= 0) return StepToward(game, scratch, interesting);
+  action.wait = true;
+  return action;
+}
+
+static RunStats PlayGame(const BalanceConfig &config, uint64_t seed,
+                         BotScratch &scratch) {
+  const float dt = 0.125f;
+  GameConfig gameConfig = config.game;
+  gameConfig.seed = seed;
+  Game game;
+  InitGame(game, gameConfig, 1280, 720);
+
+  RunStats stats = {};
+  stats.killer = -1;
+  int idleFrames = 0;
+  while (game.turn < config.maxTurns) {
+    InputAction action = BotAction(game, config, scratch);
+    int potions = game.player.potions;
+    int turn = game.turn;
+    GameMode mode = game.mode;
+    UpdateGame(game, action, dt);
+    idleFrames = game.turn == turn && game.mode == mode ? idleFrames + 1 : 0;
+    if (idleFrames >= kMaxIdleFrames) {
+      stats.stalled = true;
+      break;
+    }
+    if (action.usePotion && game.player.potions < potions) {
+      stats.potionsUsed++;
+    }
+    if (mode == GameMode::Playing && game.mode == GameMode::GameOver) {
+      stats.killer = game.lastHitBy;
+      break;
+    }
+  }
+  stats.floor = game.floor;
+  stats.turns = game.turn;
+  stats.gold = game.player.gold;
+  return stats;
+}
+
+static void BalanceWorker(const BalanceConfig &config, std::atomic<int> &next,
+                          WorkerTotals &totals) {
+  BotScratch scratch;
+  totals = WorkerTotals{};
+  while (true) {
+    int i = next.fetch_add(1);
+    if (i >= config.games) break;
+    RunStats stats = PlayGame(config, (uint64_t)(config.firstSeed + i),
+                              scratch);
+    totals.games++;
+    totals.floors += stats.floor;
+    totals.turns += stats.turns;
+    totals.gold += stats.gold;
+    totals.potionsUsed += stats.potionsUsed;
+    if (stats.killer == 0 || stats.killer == 1) {
+      totals.deaths[stats.killer]++;
+    } else {
+      totals.survived++;
+    }
+    if (stats.stalled) totals.stalled++;
+    totals.floorHistogram[std::min(stats.floor, kMaxFloorBucket - 1)]++;
+    totals.deepest = std::max(totals.deepest, stats.floor);
+  }
+}
+
+static void Usage(const char *name) {
+  std::fprintf(stderr,
+               "usage: %s [--from SEED] [--games N] [--threads N]\n"
+               "          [--map WxH] [--max-turns N] [--damage A,B]\n"
+               "          [--speed A,B] [--sleeping 0|1]\n"
+               "          [--potion-pct N] [--explore-pct N]\n",
+               name);
+}
+
+int main(int argc, char **argv) {
+  BalanceConfig config;
+  config.game = DefaultGameConfig(1);
+  config.firstSeed = 1;
+  config.games = 2000;
+  config.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  config.maxTurns = 4000;
+  config.potionPct = 40;
+  config.explorePct = 60;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) {
+      Usage(argv[0]);
+      return 1;
+    }
+    i++;
+    if (std::strcmp(arg, "--from") == 0) {
+      config.firstSeed = std::atoll(value);
+    } else if (std::strcmp(arg, "--games") == 0) {
+      config.games = std::atoi(value);
+    } else if (std::strcmp(arg, "--threads") == 0) {
+      config.threads = std::max(1, std::atoi(value));
+    } else if (std::strcmp(arg, "--map") == 0) {
+      if (std::sscanf(value, "%dx%d", &config.game.mapWidth,
+                      &config.game.mapHeight) != 2) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else if (std::strcmp(arg, "--max-turns") == 0) {
+      config.maxTurns = std::atoi(value);
+    } else if (std::strcmp(arg, "--damage") == 0) {
+      if (std::sscanf(value, "%d,%d", &config.game.enemyDamage[0],
+                      &config.game.enemyDamage[1]) != 2) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else if (std::strcmp(arg, "--speed") == 0) {
+      if (std::sscanf(value, "%d,%d", &config.game.enemySpeed[0],
+                      &config.game.enemySpeed[1]) != 2) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else if (std::strcmp(arg, "--sleeping") == 0) {
+      config.game.sleepingEnemies = std::atoi(value) != 0;
+    } else if (std::strcmp(arg, "--potion-pct") == 0) {
+      config.potionPct = std::max(0, std::min(99, std::atoi(value)));
+    } else if (std::strcmp(arg, "--explore-pct") == 0) {
+      config.explorePct = std::atoi(value);
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (config.games <= 0 || config.maxTurns <= 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  std::atomic<int> next{0};
+  std::vector<WorkerTotals> results(config.threads);
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < config.threads; t++) {
+    workers.emplace_back(BalanceWorker, std::cref(config), std::ref(next),
+                         std::ref(results[t]));
+  }
+  for (auto &worker : workers) worker.join();
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  WorkerTotals total = {};
+  for (const auto &result : results) {
+    total.games += result.games;
+    total.floors += result.floors;
+    total.turns += result.turns;
+    total.gold += result.gold;
+    total.potionsUsed += result.potionsUsed;
+    total.deaths[0] += result.deaths[0];
+    total.deaths[1] += result.deaths[1];
+    total.survived += result.survived;
+    total.stalled += result.stalled;
+    for (int f = 0; f < kMaxFloorBucket; f++) {
+      total.floorHistogram[f] += result.floorHistogram[f];
+    }
+    total.deepest = std::max(total.deepest, result.deepest);
+  }
+
+  double games = (double)total.games;
+  std::printf("games        %lld (%dx%d) on %d threads\n", total.games,
+              config.game.mapWidth, config.game.mapHeight, config.threads);
+  std::printf("damage       %d,%d\n", config.game.enemyDamage[0],
+              config.game.enemyDamage[1]);
+  std::printf("speed        %d,%d%s\n", config.game.enemySpeed[0],
+              config.game.enemySpeed[1],
+              config.game.sleepingEnemies ? " (sleeping)" : "");
+  std::printf("avg floor    %.2f (deepest %d)\n", total.floors / games,
+              total.deepest);
+  std::printf("killed by    type0 %lld  type1 %lld  survived %lld\n",
+              total.deaths[0], total.deaths[1], total.survived);
+  if (total.stalled > 0) {
+    std::printf("stalled      %lld (no turn for %d frames)\n",
+                total.stalled, kMaxIdleFrames);
+  }
+  std::printf("avg turns    %.1f\n", total.turns / games);
+  std::printf("avg gold     %.1f\n", total.gold / games);
+  std::printf("avg potions  %.2f\n", total.potionsUsed / games);
+  std::printf("floors      ");
+  for (int f = 1; f < kMaxFloorBucket; f++) {
+    if (total.floorHistogram[f] == 0) continue;
+    std::printf(" %d%s:%lld", f, f == kMaxFloorBucket - 1 ? "+" : "",
+                total.floorHistogram[f]);
+  }
+  std::printf("\n");
+  std::printf("throughput   %.1f games/s\n", games / seconds);
+  return 0;
+}
@@ -0,0 +1,363 @@
+#include "game_internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+static thread_local uint64_t tAllocs = 0;
+
+void *operator new(std::size_t size) {
+  tAllocs++;
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+struct BenchResult {
+  char name[48];
+  double nsPerOp;
+  double allocsPerOp;
+};
+
+struct BenchOptions {
+  double minMs;
+  const char *filter;
+  const char *baselinePath;
+  const char *savePath;
+  double threshold;
+};
+
+static volatile uint64_t gSink = 0;
+
+static bool Selected(const BenchOptions &options, const char *name) {
+  return !options.filter || std::strstr(name, options.filter) != nullptr;
+}
+
+static const int kSamples = 5;
+
+template <typename Op>
+static double TimeOps(Op &op, long iters) {
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iters; i++) op();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename Op, typename Reset>
+static void RunBench(const BenchOptions &options,
+                     std::vector<BenchResult> &results, const char *name,
+                     Op op, Reset reset) {
+  if (!Selected(options, name)) return;
+  reset();
+  op();
+  double sampleMs = options.minMs / kSamples;
+  long iters = 1;
+  for (;;) {
+    reset();
+    double ms = TimeOps(op, iters);
+    if (ms >= sampleMs || iters >= (1L << 30)) break;
+    long scaled = ms > 0.0 ? (long)(iters * sampleMs / ms * 1.2) : 0;
+    iters = std::max(iters * 2, std::min(scaled, iters * 100));
+  }
+
+  BenchResult result;
+  std::snprintf(result.name, sizeof(result.name), "%s", name);
+  double samples[kSamples];
+  uint64_t allocs = 0;
+  for (int s = 0; s < kSamples; s++) {
+    reset();
+    uint64_t before = tAllocs;
+    samples[s] = TimeOps(op, iters) * 1e6 / iters;
+    allocs += tAllocs - before;
+  }
+  std::sort(samples, samples + kSamples);
+  result.nsPerOp = samples[kSamples / 2];
+  result.allocsPerOp = (double)allocs / ((double)iters * kSamples);
+  results.push_back(result);
+}
+
+template <typename Op>
+static void RunBench(const BenchOptions &options,
+                     std::vector<BenchResult> &results, const char *name,
+                     Op op) {
+  RunBench(options, results, name, op, [] {});
+}
+
+static void StartBenchGame(Game &game, int width, int height) {
+  GameConfig config = DefaultGameConfig(7);
+  config.mapWidth = width;
+  config.mapHeight = height;
+  InitGame(game, config, 1280, 720);
+  game.pendingFloor.wait();
+}
+
+static void BenchGenerate(const BenchOptions &options,
+                          std::vector<BenchResult> &results) {
+  static const int sizes[][2] = {
+      {32, 24}, {64, 48}, {128, 128}, {256, 256}, {1024, 1024}};
+  for (const auto &size : sizes) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "generate/%dx%d", size[0], size[1]);
+    int next = 0;
+    RunBench(
+        options, results, name,
+        [&] {
+          int seed = 1 + (next++ & 15);
+          Dungeon dungeon =
+              GenerateDungeon(size[0], size[1], seed, GenerateMode::Auto);
+          gSink += dungeon.rooms.size();
+        },
+        [&] { next = 0; });
+  }
+}
+
+static void BenchVisibility(const BenchOptions &options,
+                            std::vector<BenchResult> &results) {
+  static const int sizes[][2] = {{32, 24}, {256, 256}, {1024, 1024}};
+  for (const auto &size : sizes) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "visibility/%dx%d", size[0], size[1]);
+    if (!Selected(options, name)) continue;
+    Game game;
+    StartBenchGame(game, size[0], size[1]);
+    RunBench(options, results, name, [&] {
+      game.fovDirty = true;
+      UpdateVisibility(game);
+      gSink += game.exploredTiles;
+    });
+  }
+}
+
+static void PlaceEnemies(Game &game, int count) {
+  Dungeon &dungeon = game.dungeon;
+  std::vector<GridPos> cells;
+  ForEachSetBit(dungeon.open, TileRect{0, 0, dungeon.width, dungeon.height},
+                [&](int x, int y) {
+                  GridPos cell{x, y};
+                  if (!(cell == game.player.actor.cell)) cells.push_back(cell);
+                });
+  Rng rng = MakeRng((uint64_t)count, RngStream::Populate);
+  ClearEnemies(game.enemies);
+  ResetScheduler(game.scheduler);
+  std::fill(game.occupancy.enemies.begin(), game.occupancy.enemies.end(), 0);
+  for (int i = 0; i < count && i < (int)cells.size(); i++) {
+    int pick = RandomValue(rng, i, (int)cells.size() - 1);
+    std::swap(cells[i], cells[pick]);
+    int type = i & 1;
+    int index = SpawnEnemy(game.enemies, cells[i], type, 5, 100 - 25 * type);
+    game.enemies.awake[index] = 1;
+    game.occupancy.enemies[CellIndex(game, cells[i])] = index + 1;
+    ScheduleEnemy(game.scheduler, game.enemies, index, game.scheduler.now);
+  }
+}
+
+static void BenchEnemyTurn(const BenchOptions &options,
+                           std::vector<BenchResult> &results) {
+  static const int counts[] = {10, 100, 1000, 10000};
+  for (int count : counts) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "enemy_turn/%d", count);
+    if (!Selected(options, name)) continue;
+    Game game;
+    StartBenchGame(game, 512, 512);
+    PlaceEnemies(game, count);
+    EnemyPool enemies = game.enemies;
+    TurnScheduler scheduler = game.scheduler;
+    std::vector<int32_t> occupancy = game.occupancy.enemies;
+    Rng combatRng = game.combatRng;
+    RunBench(
+        options, results, name,
+        [&] {
+          EnemyTurn(game);
+          game.player.hp = game.player.maxHp;
+          gSink += game.scheduler.now;
+        },
+        [&] {
+          game.enemies = enemies;
+          game.scheduler = scheduler;
+          game.occupancy.enemies = occupancy;
+          game.combatRng = combatRng;
+        });
+  }
+}
+
+static void BenchOccupancy(const BenchOptions &options,
+                           std::vector<BenchResult> &results) {
+  if (!Selected(options, "occupancy/is_occupied") &&
+      !Selected(options, "occupancy/item_at")) {
+    return;
+  }
+  Game game;
+  StartBenchGame(game, 256, 256);
+  const int kProbes = 4096;
+  std::vector<GridPos> probes(kProbes);
+  Rng rng = MakeRng(11, RngStream::Cosmetic);
+  for (auto &cell : probes) {
+    cell = GridPos{RandomValue(rng, 0, game.dungeon.width - 1),
+                   RandomValue(rng, 0, game.dungeon.height - 1)};
+  }
+  uint32_t next = 0;
+  RunBench(options, results, "occupancy/is_occupied", [&] {
+    gSink += IsOccupied(game, probes[next++ & (kProbes - 1)]);
+  });
+  RunBench(options, results, "occupancy/item_at", [&] {
+    gSink += ItemAt(game, probes[next++ & (kProbes - 1)]) != nullptr;
+  });
+}
+
+static void BenchLog(const BenchOptions &options,
+                     std::vector<BenchResult> &results) {
+  if (!Selected(options, "log/add") && !Selected(options, "log/advance")) {
+    return;
+  }
+  Game game;
+  StartBenchGame(game, 32, 24);
+  int arg = 0;
+  RunBench(options, results, "log/add", [&] {
+    AddLog(game, LogMsg::PlayerHit, arg++);
+  });
+  RunBench(options, results, "log/advance", [&] {
+    AdvanceLog(game.log, 1.0f / 60.0f);
+    gSink += LogSize(game.log);
+  });
+}
+
+static bool LoadBaseline(const char *path, std::vector<BenchResult> &out) {
+  FILE *file = std::fopen(path, "r");
+  if (!file) return false;
+  char line[160];
+  while (std::fgets(line, sizeof(line), file)) {
+    if (line[0] == '#') continue;
+    BenchResult result;
+    if (std::sscanf(line, "%47s %lf %lf", result.name, &result.nsPerOp,
+                    &result.allocsPerOp) == 3) {
+      out.push_back(result);
+    }
+  }
+  std::fclose(file);
+  return true;
+}
+
+static bool SaveBaseline(const char *path,
+                         const std::vector<BenchResult> &results) {
+  FILE *file = std::fopen(path, "w");
+  if (!file) return false;
+  std::fprintf(file, "# name ns_per_op allocs_per_op\n");
+  for (const auto &result : results) {
+    std::fprintf(file, "%s %.3f %.4f\n", result.name, result.nsPerOp,
+                 result.allocsPerOp);
+  }
+  return std::fclose(file) == 0;
+}
+
+static const BenchResult *FindResult(const std::vector<BenchResult> &results,
+                                     const char *name) {
+  for (const auto &result : results) {
+    if (std::strcmp(result.name, name) == 0) return &result;
+  }
+  return nullptr;
+}
+
+static void Usage(const char *exe) {
+  std::fprintf(stderr,
+               "usage: %s [--filter TEXT] [--min-ms N] [--baseline FILE] "
+               "[--save-baseline FILE] [--threshold PCT]\n",
+               exe);
+}
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  options.minMs = 500.0;
+  options.filter = nullptr;
+  options.baselinePath = nullptr;
+  options.savePath = nullptr;
+  options.threshold = 10.0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) {
+      Usage(argv[0]);
+      return 1;
+    }
+    i++;
+    if (std::strcmp(arg, "--filter") == 0) {
+      options.filter = value;
+    } else if (std::strcmp(arg, "--min-ms") == 0) {
+      options.minMs = std::max(1.0, std::atof(value));
+    } else if (std::strcmp(arg, "--baseline") == 0) {
+      options.baselinePath = value;
+    } else if (std::strcmp(arg, "--save-baseline") == 0) {
+      options.savePath = value;
+    } else if (std::strcmp(arg, "--threshold") == 0) {
+      options.threshold = std::atof(value);
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<BenchResult> baseline;
+  if (options.baselinePath && !LoadBaseline(options.baselinePath, baseline)) {
+    std::fprintf(stderr, "could not read baseline: %s\n",
+                 options.baselinePath);
+    return 1;
+  }
+
+  std::vector<BenchResult> results;
+  BenchGenerate(options, results);
+  BenchVisibility(options, results);
+  BenchEnemyTurn(options, results);
+  BenchOccupancy(options, results);
+  BenchLog(options, results);
+  if (results.empty()) {
+    std::fprintf(stderr, "no benchmark matches filter: %s\n",
+                 options.filter ? options.filter : "");
+    return 1;
+  }
+
+  int regressions = 0;
+  double limit = 1.0 + options.threshold / 100.0;
+  for (const auto &result : results) {
+    std::printf("%-24s %12.1f ns/op %9.2f allocs/op", result.name,
+                result.nsPerOp, result.allocsPerOp);
+    const BenchResult *base = FindResult(baseline, result.name);
+    if (base) {
+      double delta = base->nsPerOp > 0.0
+                         ? (result.nsPerOp / base->nsPerOp - 1.0) * 100.0
+                         : 0.0;
+      bool slower = result.nsPerOp > base->nsPerOp * limit;
+      bool allocs = result.allocsPerOp > base->allocsPerOp * limit + 0.5;
+      std::printf("  %+6.1f%%", delta);
+      if (slower || allocs) {
+        std::printf("  REGRESSION%s", allocs ? " (allocs)" : "");
+        regressions++;
+      }
+    }
+    std::printf("\n");
+  }
+
+  if (options.savePath && !SaveBaseline(options.savePath, results)) {
+    std::fprintf(stderr, "could not write baseline: %s\n", options.savePath);
+    return 1;
+  }
+  if (regressions > 0) {
+    std::printf("%d regression(s) beyond %.0f%%\n", regressions,
+                options.threshold);
+    return 2;
+  }
+  return 0;
+}
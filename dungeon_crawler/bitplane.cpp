@@ -0,0 +1,61 @@
+#include "bitplane.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void ResizeBitPlane(BitPlane &plane, int width, int height) {
+  plane.width = width;
+  plane.height = height;
+  plane.stride = (width + 63) / 64;
+  plane.words.assign((size_t)plane.stride * height, 0);
+}
+
+void ClearBitRows(BitPlane &plane, int y0, int y1) {
+  y0 = std::max(0, y0);
+  y1 = std::min(plane.height, y1);
+  if (y0 >= y1) return;
+  auto first = plane.words.begin() + (size_t)y0 * plane.stride;
+  std::fill(first, first + (size_t)(y1 - y0) * plane.stride, 0);
+}
+
+void UnionBitRows(BitPlane &dst, const BitPlane &src, int y0, int y1) {
+  y0 = std::max(0, y0);
+  y1 = std::min(std::min(dst.height, src.height), y1);
+  if (y0 >= y1) return;
+  uint64_t *out = dst.words.data() + (size_t)y0 * dst.stride;
+  const uint64_t *in = src.words.data() + (size_t)y0 * src.stride;
+  size_t count = (size_t)(y1 - y0) * dst.stride;
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 2 <= count; i += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(out + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(in + i));
+    _mm_storeu_si128((__m128i *)(out + i), _mm_or_si128(a, b));
+  }
+#endif
+  for (; i < count; i++) out[i] |= in[i];
+}
+
+int CountNewBits(const BitPlane &dst, const BitPlane &src,
+                 const BitPlane &mask, int y0, int y1) {
+  y0 = std::max(0, y0);
+  y1 = std::min(std::min(dst.height, src.height), y1);
+  if (y0 >= y1) return 0;
+  size_t begin = (size_t)y0 * dst.stride;
+  size_t end = (size_t)y1 * dst.stride;
+  int total = 0;
+  for (size_t i = begin; i < end; i++) {
+    uint64_t fresh = src.words[i] & mask.words[i] & ~dst.words[i];
+    total += __builtin_popcountll(fresh);
+  }
+  return total;
+}
+
+int CountBits(const BitPlane &plane) {
+  int total = 0;
+  for (uint64_t word : plane.words) total += __builtin_popcountll(word);
+  return total;
+}
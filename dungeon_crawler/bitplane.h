@@ -0,0 +1,53 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+#include <vector>
+
+struct BitPlane {
+  int width;
+  int height;
+  int stride;
+  std::vector<uint64_t> words;
+};
+
+void ResizeBitPlane(BitPlane &plane, int width, int height);
+void ClearBitRows(BitPlane &plane, int y0, int y1);
+void UnionBitRows(BitPlane &dst, const BitPlane &src, int y0, int y1);
+int CountNewBits(const BitPlane &dst, const BitPlane &src,
+                 const BitPlane &mask, int y0, int y1);
+int CountBits(const BitPlane &plane);
+
+inline bool TestBit(const BitPlane &plane, int x, int y) {
+  uint64_t word = plane.words[y * plane.stride + (x >> 6)];
+  return (word >> (x & 63)) & 1;
+}
+
+inline void SetBit(BitPlane &plane, int x, int y) {
+  plane.words[y * plane.stride + (x >> 6)] |= 1ULL << (x & 63);
+}
+
+template <typename Visit>
+void ForEachSetBit(const BitPlane &plane, TileRect rect, Visit visit) {
+  int x0 = rect.x < 0 ? 0 : rect.x;
+  int y0 = rect.y < 0 ? 0 : rect.y;
+  int x1 = rect.x + rect.w > plane.width ? plane.width : rect.x + rect.w;
+  int y1 = rect.y + rect.h > plane.height ? plane.height : rect.y + rect.h;
+  if (x0 >= x1 || y0 >= y1) return;
+  int w0 = x0 >> 6;
+  int w1 = (x1 - 1) >> 6;
+  for (int y = y0; y < y1; y++) {
+    const uint64_t *row = plane.words.data() + y * plane.stride;
+    for (int w = w0; w <= w1; w++) {
+      uint64_t bits = row[w];
+      if (w == w0) bits &= ~0ULL << (x0 & 63);
+      if (w == w1 && (x1 & 63) != 0) bits &= ~0ULL >> (64 - (x1 & 63));
+      while (bits) {
+        int x = (w << 6) + __builtin_ctzll(bits);
+        visit(x, y);
+        bits &= bits - 1;
+      }
+    }
+  }
+}
@@ -1 +1,5 @@
-g++ main.cpp game.cpp game_state.cpp dungeon.cpp input.cpp render.cpp ui.cpp -std=c++17 -O2 -lraylib -lGL -lm -lpthread -ldl -lrt -lX11
+g++ main.cpp game.cpp game_state.cpp dungeon.cpp rng.cpp bitplane.cpp flowfield.cpp message_log.cpp profiler.cpp replay.cpp savegame.cpp enemy_pool.cpp scheduler.cpp action_queue.cpp input.cpp render.cpp sprites.cpp ui.cpp lightmap.cpp -std=c++17 -O2 -lraylib -lGL -lm -lpthread -ldl -lrt -lX11
+g++ headless.cpp game.cpp game_state.cpp dungeon.cpp rng.cpp bitplane.cpp flowfield.cpp message_log.cpp profiler.cpp replay.cpp savegame.cpp enemy_pool.cpp scheduler.cpp action_queue.cpp -std=c++17 -O2 -lm -lpthread -o dungeon_headless
+g++ seed_scanner.cpp dungeon.cpp rng.cpp bitplane.cpp -std=c++17 -O2 -lm -lpthread -o seed_scanner
+g++ balance.cpp game.cpp game_state.cpp dungeon.cpp rng.cpp bitplane.cpp flowfield.cpp message_log.cpp profiler.cpp replay.cpp savegame.cpp enemy_pool.cpp scheduler.cpp action_queue.cpp -std=c++17 -O2 -lm -lpthread -o balance
+g++ bench.cpp game.cpp game_state.cpp dungeon.cpp rng.cpp bitplane.cpp flowfield.cpp message_log.cpp profiler.cpp replay.cpp savegame.cpp enemy_pool.cpp scheduler.cpp action_queue.cpp -std=c++17 -O2 -lm -lpthread -o bench
@@ -1,7 +1,7 @@
 #include "dungeon.h"
 
-#include <raylib.h>
-
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 static bool RoomsOverlap(const Room &a, const Room &b) {
@@ -9,27 +9,38 @@ static bool RoomsOverlap(const Room &a, const Room &b) {
          a.y - 1 < b.y + b.h && a.y + a.h + 1 > b.y;
 }
 
-bool InBounds(const Dungeon &dungeon, int x, int y) {
-  return x >= 0 && y >= 0 && x < dungeon.width && y < dungeon.height;
-}
-
-int TileIndex(const Dungeon &dungeon, int x, int y) {
-  return y * dungeon.width + x;
-}
-
-TileType GetTile(const Dungeon &dungeon, int x, int y) {
-  return dungeon.tiles[TileIndex(dungeon, x, y)];
+void ResizeTiles(Dungeon &dungeon, int width, int height) {
+  dungeon.width = width;
+  dungeon.height = height;
+  dungeon.stride = width + 2;
+  dungeon.tiles.assign((size_t)dungeon.stride * (height + 2), TileType::Wall);
+  dungeon.flags.clear();
 }
 
-bool IsWalkable(const Dungeon &dungeon, int x, int y) {
-  if (!InBounds(dungeon, x, y)) return false;
-  TileType tile = GetTile(dungeon, x, y);
-  return tile == TileType::Floor || tile == TileType::Door;
+void BuildTileFlags(Dungeon &dungeon) {
+  static const uint8_t kTypeFlags[3] = {kTileOpaque, kTileWalkable,
+                                        kTileWalkable | kTileDoor};
+  dungeon.flags.resize(dungeon.tiles.size());
+  for (size_t i = 0; i < dungeon.tiles.size(); i++) {
+    dungeon.flags[i] = kTypeFlags[(int)dungeon.tiles[i]];
+  }
+  ResizeBitPlane(dungeon.open, dungeon.width, dungeon.height);
+  for (int y = 0; y < dungeon.height; y++) {
+    const uint8_t *row = dungeon.flags.data() + TileSlot(dungeon, 0, y);
+    uint64_t *words = dungeon.open.words.data() + y * dungeon.open.stride;
+    for (int x = 0; x < dungeon.width; x++) {
+      uint64_t open = (row[x] & kTileWalkable) != 0;
+      words[x >> 6] |= open << (x & 63);
+    }
+  }
+  if (InBounds(dungeon, dungeon.exit.x, dungeon.exit.y)) {
+    SetTileFlag(dungeon, dungeon.exit, kTileExit, true);
+  }
 }
 
 static void SetTile(Dungeon &dungeon, int x, int y, TileType type) {
   if (!InBounds(dungeon, x, y)) return;
-  dungeon.tiles[TileIndex(dungeon, x, y)] = type;
+  dungeon.tiles[TileSlot(dungeon, x, y)] = type;
 }
 
 static void CarveRoom(Dungeon &dungeon, const Room &room) {
@@ -40,94 +51,222 @@ static void CarveRoom(Dungeon &dungeon, const Room &room) {
   }
 }
 
-static std::vector<GridPos> BuildCorridorPath(GridPos a, GridPos b) {
-  std::vector<GridPos> path;
+template <typename Visit>
+static void WalkCorridor(GridPos a, GridPos b, Visit visit) {
   int x = a.x;
   int y = a.y;
-  path.push_back(GridPos{x, y});
+  visit(GridPos{x, y});
   while (x != b.x) {
     x += (b.x > x) ? 1 : -1;
-    path.push_back(GridPos{x, y});
+    visit(GridPos{x, y});
   }
   while (y != b.y) {
     y += (b.y > y) ? 1 : -1;
-    path.push_back(GridPos{x, y});
+    visit(GridPos{x, y});
   }
-  return path;
 }
 
-static void CarvePath(Dungeon &dungeon, const std::vector<GridPos> &path) {
-  for (const auto &cell : path) {
+static void ConnectRooms(Dungeon &dungeon, const Room &from, const Room &to) {
+  GridPos prev{-1, -1};
+  GridPos doorFrom{-1, -1};
+  GridPos doorTo{-1, -1};
+  bool first = true;
+  WalkCorridor(from.Center(), to.Center(), [&](GridPos cell) {
     SetTile(dungeon, cell.x, cell.y, TileType::Floor);
-  }
-}
-
-static void PlaceDoorAtBoundary(Dungeon &dungeon, const Room &room,
-                                const std::vector<GridPos> &path,
-                                bool fromStart) {
-  if (path.size() < 2) return;
-  if (fromStart) {
-    for (size_t i = 1; i < path.size(); i++) {
-      if (room.Contains(path[i - 1]) && !room.Contains(path[i])) {
-        SetTile(dungeon, path[i - 1].x, path[i - 1].y, TileType::Door);
-        return;
-      }
-    }
-  } else {
-    for (size_t i = path.size() - 1; i > 0; i--) {
-      if (room.Contains(path[i]) && !room.Contains(path[i - 1])) {
-        SetTile(dungeon, path[i].x, path[i].y, TileType::Door);
-        return;
+    if (!first) {
+      if (doorFrom.x < 0 && from.Contains(prev) && !from.Contains(cell)) {
+        doorFrom = prev;
       }
+      if (to.Contains(cell) && !to.Contains(prev)) doorTo = cell;
     }
-  }
+    prev = cell;
+    first = false;
+  });
+  if (doorFrom.x >= 0) SetTile(dungeon, doorFrom.x, doorFrom.y, TileType::Door);
+  if (doorTo.x >= 0) SetTile(dungeon, doorTo.x, doorTo.y, TileType::Door);
 }
 
-GridPos RandomFloorInRoom(const Dungeon &dungeon, const Room &room) {
-  int x = GetRandomValue(room.x + 1, room.x + room.w - 2);
-  int y = GetRandomValue(room.y + 1, room.y + room.h - 2);
+GridPos RandomFloorInRoom(const Dungeon &dungeon, const Room &room, Rng &rng) {
+  int x = RandomValue(rng, room.x + 1, room.x + room.w - 2);
+  int y = RandomValue(rng, room.y + 1, room.y + room.h - 2);
   if (GetTile(dungeon, x, y) == TileType::Floor) return GridPos{x, y};
   return room.Center();
 }
 
-Dungeon GenerateDungeon(int width, int height, int seed) {
-  SetRandomSeed(seed);
-  Dungeon dungeon;
-  dungeon.width = width;
-  dungeon.height = height;
-  dungeon.tiles.assign(width * height, TileType::Wall);
-  dungeon.seen.assign(width * height, 0);
-  dungeon.rooms.clear();
+struct RoomBuckets {
+  int cellsX;
+  int cellsY;
+  std::vector<int> head;
+  std::vector<int> room;
+  std::vector<int> next;
+};
+
+static const int kBucketSize = 16;
+
+static void InitBuckets(RoomBuckets &buckets, int width, int height) {
+  buckets.cellsX = (width + kBucketSize - 1) / kBucketSize;
+  buckets.cellsY = (height + kBucketSize - 1) / kBucketSize;
+  buckets.head.assign(buckets.cellsX * buckets.cellsY, -1);
+}
+
+template <typename Visit>
+static bool ForEachBucket(const RoomBuckets &buckets, int x0, int y0, int x1,
+                          int y1, Visit visit) {
+  int bx0 = std::max(0, x0 / kBucketSize);
+  int by0 = std::max(0, y0 / kBucketSize);
+  int bx1 = std::min(buckets.cellsX - 1, x1 / kBucketSize);
+  int by1 = std::min(buckets.cellsY - 1, y1 / kBucketSize);
+  for (int by = by0; by <= by1; by++) {
+    for (int bx = bx0; bx <= bx1; bx++) {
+      if (visit(by * buckets.cellsX + bx)) return true;
+    }
+  }
+  return false;
+}
+
+static bool OverlapsAny(const RoomBuckets &buckets,
+                        const std::vector<Room> &rooms, const Room &room) {
+  return ForEachBucket(
+      buckets, room.x - 1, room.y - 1, room.x + room.w, room.y + room.h,
+      [&](int bucket) {
+        for (int n = buckets.head[bucket]; n >= 0; n = buckets.next[n]) {
+          if (RoomsOverlap(room, rooms[buckets.room[n]])) return true;
+        }
+        return false;
+      });
+}
+
+static void AddToBuckets(RoomBuckets &buckets, const Room &room, int index) {
+  ForEachBucket(buckets, room.x, room.y, room.x + room.w - 1,
+                room.y + room.h - 1, [&](int bucket) {
+                  buckets.room.push_back(index);
+                  buckets.next.push_back(buckets.head[bucket]);
+                  buckets.head[bucket] = (int)buckets.next.size() - 1;
+                  return false;
+                });
+}
 
-  int targetRooms = GetRandomValue(8, 12);
+static void GenerateScattered(Dungeon &dungeon, Rng &rng) {
+  int width = dungeon.width;
+  int height = dungeon.height;
+  RoomBuckets buckets;
+  InitBuckets(buckets, width, height);
+  int areaScale = std::max(1, (width * height) / (32 * 24));
+  int targetRooms = RandomValue(rng, 8, 12) * areaScale;
+  int maxAttempts = 120 * areaScale;
   int attempts = 0;
-  while ((int)dungeon.rooms.size() < targetRooms && attempts < 120) {
+  while ((int)dungeon.rooms.size() < targetRooms && attempts < maxAttempts) {
     attempts++;
-    int w = GetRandomValue(4, 8);
-    int h = GetRandomValue(4, 7);
-    int x = GetRandomValue(1, width - w - 2);
-    int y = GetRandomValue(1, height - h - 2);
+    int w = RandomValue(rng, 4, 8);
+    int h = RandomValue(rng, 4, 7);
+    int x = RandomValue(rng, 1, width - w - 2);
+    int y = RandomValue(rng, 1, height - h - 2);
     Room room{x, y, w, h};
-
-    bool overlap = false;
-    for (const auto &r : dungeon.rooms) {
-      if (RoomsOverlap(room, r)) {
-        overlap = true;
-        break;
-      }
-    }
-    if (overlap) continue;
+    if (OverlapsAny(buckets, dungeon.rooms, room)) continue;
 
     CarveRoom(dungeon, room);
     if (!dungeon.rooms.empty()) {
-      GridPos a = dungeon.rooms.back().Center();
-      GridPos b = room.Center();
-      std::vector<GridPos> path = BuildCorridorPath(a, b);
-      CarvePath(dungeon, path);
-      PlaceDoorAtBoundary(dungeon, dungeon.rooms.back(), path, true);
-      PlaceDoorAtBoundary(dungeon, room, path, false);
+      ConnectRooms(dungeon, dungeon.rooms.back(), room);
     }
+    AddToBuckets(buckets, room, (int)dungeon.rooms.size());
+    dungeon.rooms.push_back(room);
+  }
+}
+
+static const int kLeafMin = 9;
+
+static void SplitBsp(Dungeon &dungeon, Rng &rng, TileRect area, int &first,
+                     int &last) {
+  bool canX = area.w >= kLeafMin * 2;
+  bool canY = area.h >= kLeafMin * 2;
+  if (!canX && !canY) {
+    int w = RandomValue(rng, 4, std::min(8, area.w - 2));
+    int h = RandomValue(rng, 4, std::min(7, area.h - 2));
+    int x = RandomValue(rng, area.x + 1, area.x + area.w - w - 1);
+    int y = RandomValue(rng, area.y + 1, area.y + area.h - h - 1);
+    Room room{x, y, w, h};
+    CarveRoom(dungeon, room);
+    first = last = (int)dungeon.rooms.size();
     dungeon.rooms.push_back(room);
+    return;
+  }
+
+  bool splitX = canX;
+  if (canX && canY) {
+    if (area.w * 4 > area.h * 5) splitX = true;
+    else if (area.h * 4 > area.w * 5) splitX = false;
+    else splitX = RandomValue(rng, 0, 1) == 0;
+  }
+  TileRect a = area;
+  TileRect b = area;
+  if (splitX) {
+    int cut = RandomValue(rng, kLeafMin, area.w - kLeafMin);
+    a.w = cut;
+    b.x += cut;
+    b.w -= cut;
+  } else {
+    int cut = RandomValue(rng, kLeafMin, area.h - kLeafMin);
+    a.h = cut;
+    b.y += cut;
+    b.h -= cut;
+  }
+  int aFirst, aLast, bFirst, bLast;
+  SplitBsp(dungeon, rng, a, aFirst, aLast);
+  SplitBsp(dungeon, rng, b, bFirst, bLast);
+  ConnectRooms(dungeon, dungeon.rooms[aLast], dungeon.rooms[bFirst]);
+  first = aFirst;
+  last = bLast;
+}
+
+static void GeneratePartitioned(Dungeon &dungeon, Rng &rng) {
+  int cols = dungeon.width / kLeafMin + 1;
+  int rows = dungeon.height / kLeafMin + 1;
+  dungeon.rooms.reserve(cols * rows);
+  int first, last;
+  SplitBsp(dungeon, rng, TileRect{0, 0, dungeon.width, dungeon.height}, first,
+           last);
+}
+
+bool ParseGenerateMode(const char *name, GenerateMode &mode) {
+  for (int i = 0; i <= (int)GenerateMode::Partitioned; i++) {
+    if (std::strcmp(name, GenerateModeName((GenerateMode)i)) == 0) {
+      mode = (GenerateMode)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *GenerateModeName(GenerateMode mode) {
+  switch (mode) {
+    case GenerateMode::Auto:
+      return "auto";
+    case GenerateMode::Scattered:
+      return "scattered";
+    case GenerateMode::Partitioned:
+      return "partitioned";
+  }
+  return "auto";
+}
+
+GenerateMode ResolveGenerateMode(GenerateMode mode, int width, int height) {
+  if (mode != GenerateMode::Auto) return mode;
+  return width * height > 128 * 128 ? GenerateMode::Partitioned
+                                    : GenerateMode::Scattered;
+}
+
+Dungeon GenerateDungeon(int width, int height, int seed,
+                        GenerateMode mode) {
+  Rng rng = MakeRng((uint64_t)seed, RngStream::Generate);
+  Dungeon dungeon;
+  ResizeTiles(dungeon, width, height);
+  ResizeBitPlane(dungeon.seen, width, height);
+  dungeon.rooms.clear();
+
+  if (ResolveGenerateMode(mode, width, height) == GenerateMode::Partitioned) {
+    GeneratePartitioned(dungeon, rng);
+  } else {
+    GenerateScattered(dungeon, rng);
   }
 
   if (dungeon.rooms.empty()) {
@@ -137,5 +276,6 @@ Dungeon GenerateDungeon(int width, int height, int seed) {
   }
 
   dungeon.exit = dungeon.rooms.back().Center();
+  BuildTileFlags(dungeon);
   return dungeon;
 }
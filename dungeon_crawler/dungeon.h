@@ -1,22 +1,66 @@
 #pragma once
 
+#include "bitplane.h"
+#include "rng.h"
 #include "types.h"
 
 #include <cstdint>
 #include <vector>
 
+enum class GenerateMode { Auto, Scattered, Partitioned };
+
+const uint8_t kTileWalkable = 1 << 0;
+const uint8_t kTileOpaque = 1 << 1;
+const uint8_t kTileDoor = 1 << 2;
+const uint8_t kTileExit = 1 << 3;
+const uint8_t kTileItem = 1 << 4;
+
 struct Dungeon {
   int width;
   int height;
+  int stride;
   std::vector<TileType> tiles;
-  std::vector<uint8_t> seen;
+  std::vector<uint8_t> flags;
+  BitPlane seen;
+  BitPlane open;
   std::vector<Room> rooms;
   GridPos exit;
 };
 
-Dungeon GenerateDungeon(int width, int height, int seed);
-bool InBounds(const Dungeon &dungeon, int x, int y);
-int TileIndex(const Dungeon &dungeon, int x, int y);
-TileType GetTile(const Dungeon &dungeon, int x, int y);
-bool IsWalkable(const Dungeon &dungeon, int x, int y);
-GridPos RandomFloorInRoom(const Dungeon &dungeon, const Room &room);
+Dungeon GenerateDungeon(int width, int height, int seed, GenerateMode mode);
+GenerateMode ResolveGenerateMode(GenerateMode mode, int width, int height);
+bool ParseGenerateMode(const char *name, GenerateMode &mode);
+const char *GenerateModeName(GenerateMode mode);
+void ResizeTiles(Dungeon &dungeon, int width, int height);
+void BuildTileFlags(Dungeon &dungeon);
+GridPos RandomFloorInRoom(const Dungeon &dungeon, const Room &room, Rng &rng);
+
+inline bool InBounds(const Dungeon &dungeon, int x, int y) {
+  return x >= 0 && y >= 0 && x < dungeon.width && y < dungeon.height;
+}
+
+inline int TileIndex(const Dungeon &dungeon, int x, int y) {
+  return y * dungeon.width + x;
+}
+
+inline int TileSlot(const Dungeon &dungeon, int x, int y) {
+  return (y + 1) * dungeon.stride + x + 1;
+}
+
+inline TileType GetTile(const Dungeon &dungeon, int x, int y) {
+  return dungeon.tiles[TileSlot(dungeon, x, y)];
+}
+
+inline bool HasTileFlag(const Dungeon &dungeon, int x, int y, uint8_t flag) {
+  return (dungeon.flags[TileSlot(dungeon, x, y)] & flag) != 0;
+}
+
+inline void SetTileFlag(Dungeon &dungeon, GridPos cell, uint8_t flag,
+                        bool on) {
+  uint8_t &bits = dungeon.flags[TileSlot(dungeon, cell.x, cell.y)];
+  bits = on ? (uint8_t)(bits | flag) : (uint8_t)(bits & ~flag);
+}
+
+inline bool IsWalkable(const Dungeon &dungeon, int x, int y) {
+  return HasTileFlag(dungeon, x, y, kTileWalkable);
+}
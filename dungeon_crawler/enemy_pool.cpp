@@ -0,0 +1,99 @@
+#include "enemy_pool.h"
+
+#include <algorithm>
+
+void ClearEnemies(EnemyPool &pool) {
+  pool.cell.clear();
+  pool.prev.clear();
+  pool.moveT.clear();
+  pool.hp.clear();
+  pool.type.clear();
+  pool.speed.clear();
+  pool.awake.clear();
+  pool.nextTurn.clear();
+  pool.turnSeq.clear();
+  pool.owner.clear();
+  pool.freeSlots.clear();
+  for (uint32_t slot = 0; slot < (uint32_t)pool.dense.size(); slot++) {
+    if (pool.dense[slot] != UINT32_MAX) pool.generation[slot]++;
+    pool.dense[slot] = UINT32_MAX;
+    pool.freeSlots.push_back(slot);
+  }
+}
+
+int SpawnEnemy(EnemyPool &pool, GridPos cell, int type, int hp, int speed) {
+  uint32_t slot;
+  if (!pool.freeSlots.empty()) {
+    slot = pool.freeSlots.back();
+    pool.freeSlots.pop_back();
+  } else {
+    slot = (uint32_t)pool.dense.size();
+    pool.dense.push_back(UINT32_MAX);
+    pool.generation.push_back(0);
+  }
+  int index = EnemyCount(pool);
+  pool.dense[slot] = (uint32_t)index;
+  pool.cell.push_back(cell);
+  pool.prev.push_back(cell);
+  pool.moveT.push_back(1.0f);
+  pool.hp.push_back(hp);
+  pool.type.push_back((uint8_t)type);
+  pool.speed.push_back((int16_t)speed);
+  pool.awake.push_back(0);
+  pool.nextTurn.push_back(0);
+  pool.turnSeq.push_back(0);
+  pool.owner.push_back(slot);
+  return index;
+}
+
+void RemoveEnemy(EnemyPool &pool, int index) {
+  uint32_t slot = pool.owner[index];
+  pool.dense[slot] = UINT32_MAX;
+  pool.generation[slot]++;
+  pool.freeSlots.push_back(slot);
+
+  int last = EnemyCount(pool) - 1;
+  if (index != last) {
+    pool.cell[index] = pool.cell[last];
+    pool.prev[index] = pool.prev[last];
+    pool.moveT[index] = pool.moveT[last];
+    pool.hp[index] = pool.hp[last];
+    pool.type[index] = pool.type[last];
+    pool.speed[index] = pool.speed[last];
+    pool.awake[index] = pool.awake[last];
+    pool.nextTurn[index] = pool.nextTurn[last];
+    pool.turnSeq[index] = pool.turnSeq[last];
+    pool.owner[index] = pool.owner[last];
+    pool.dense[pool.owner[index]] = (uint32_t)index;
+  }
+  pool.cell.pop_back();
+  pool.prev.pop_back();
+  pool.moveT.pop_back();
+  pool.hp.pop_back();
+  pool.type.pop_back();
+  pool.speed.pop_back();
+  pool.awake.pop_back();
+  pool.nextTurn.pop_back();
+  pool.turnSeq.pop_back();
+  pool.owner.pop_back();
+}
+
+EnemyHandle GetEnemyHandle(const EnemyPool &pool, int index) {
+  uint32_t slot = pool.owner[index];
+  return EnemyHandle{slot, pool.generation[slot]};
+}
+
+int FindEnemy(const EnemyPool &pool, EnemyHandle handle) {
+  if (handle.slot >= pool.dense.size()) return -1;
+  if (pool.generation[handle.slot] != handle.generation) return -1;
+  uint32_t index = pool.dense[handle.slot];
+  return index == UINT32_MAX ? -1 : (int)index;
+}
+
+void AdvanceEnemyMoves(EnemyPool &pool, float step) {
+  float *moveT = pool.moveT.data();
+  int count = EnemyCount(pool);
+  for (int i = 0; i < count; i++) {
+    moveT[i] = std::min(1.0f, moveT[i] + step);
+  }
+}
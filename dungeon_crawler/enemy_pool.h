@@ -0,0 +1,44 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+#include <vector>
+
+const int kEnemyTypes = 2;
+
+struct EnemyHandle {
+  uint32_t slot;
+  uint32_t generation;
+};
+
+struct EnemyPool {
+  std::vector<GridPos> cell;
+  std::vector<GridPos> prev;
+  std::vector<float> moveT;
+  std::vector<int32_t> hp;
+  std::vector<uint8_t> type;
+  std::vector<int16_t> speed;
+  std::vector<uint8_t> awake;
+  std::vector<int64_t> nextTurn;
+  std::vector<uint32_t> turnSeq;
+  std::vector<uint32_t> owner;
+  std::vector<uint32_t> dense;
+  std::vector<uint32_t> generation;
+  std::vector<uint32_t> freeSlots;
+};
+
+void ClearEnemies(EnemyPool &pool);
+int SpawnEnemy(EnemyPool &pool, GridPos cell, int type, int hp, int speed);
+void RemoveEnemy(EnemyPool &pool, int index);
+EnemyHandle GetEnemyHandle(const EnemyPool &pool, int index);
+int FindEnemy(const EnemyPool &pool, EnemyHandle handle);
+void AdvanceEnemyMoves(EnemyPool &pool, float step);
+
+inline int EnemyCount(const EnemyPool &pool) {
+  return (int)pool.hp.size();
+}
+
+inline Actor EnemyActor(const EnemyPool &pool, int index) {
+  return Actor{pool.cell[index], pool.prev[index], pool.moveT[index]};
+}
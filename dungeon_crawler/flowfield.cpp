@@ -0,0 +1,43 @@
+#include "flowfield.h"
+
+#include <cstddef>
+
+void ResetFlowField(FlowField &field, int width, int height, int radius) {
+  field.width = width;
+  field.height = height;
+  field.radius = radius;
+  field.valid = false;
+  field.origin = GridPos{-1, -1};
+  field.dist.assign(width * height, kFlowUnreached);
+  field.reached.clear();
+}
+
+void UpdateFlowField(FlowField &field, const Dungeon &dungeon, GridPos origin) {
+  if (field.valid && field.origin == origin) return;
+  for (int32_t idx : field.reached) field.dist[idx] = kFlowUnreached;
+  field.reached.clear();
+  field.origin = origin;
+  field.valid = true;
+  if (!IsWalkable(dungeon, origin.x, origin.y)) return;
+
+  int start = TileIndex(dungeon, origin.x, origin.y);
+  field.dist[start] = 0;
+  field.reached.push_back(start);
+  static const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (size_t head = 0; head < field.reached.size(); head++) {
+    int idx = field.reached[head];
+    int d = field.dist[idx];
+    if (d >= field.radius) continue;
+    int x = idx % field.width;
+    int y = idx / field.width;
+    for (const auto &dir : dirs) {
+      int nx = x + dir[0];
+      int ny = y + dir[1];
+      if (!IsWalkable(dungeon, nx, ny)) continue;
+      int next = ny * field.width + nx;
+      if (field.dist[next] != kFlowUnreached) continue;
+      field.dist[next] = (uint16_t)(d + 1);
+      field.reached.push_back(next);
+    }
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "dungeon.h"
+
+#include <cstdint>
+#include <vector>
+
+struct FlowField {
+  int width;
+  int height;
+  int radius;
+  bool valid;
+  GridPos origin;
+  std::vector<uint16_t> dist;
+  std::vector<int32_t> reached;
+};
+
+const uint16_t kFlowUnreached = 0xffff;
+
+void ResetFlowField(FlowField &field, int width, int height, int radius);
+void UpdateFlowField(FlowField &field, const Dungeon &dungeon, GridPos origin);
+
+inline int FlowDistance(const FlowField &field, GridPos cell) {
+  uint16_t d = field.dist[cell.y * field.width + cell.x];
+  return d == kFlowUnreached ? -1 : d;
+}
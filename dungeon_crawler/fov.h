@@ -0,0 +1,58 @@
+#pragma once
+
+#include "dungeon.h"
+
+template <typename Visit>
+void CastOctant(const Dungeon &dungeon, GridPos origin, int radius, int row,
+                float start, float end, int xx, int xy, int yx, int yy,
+                Visit &visit) {
+  if (start < end) return;
+  int radius2 = radius * radius;
+  float newStart = 0.0f;
+  for (int j = row; j <= radius; j++) {
+    bool blocked = false;
+    int dy = -j;
+    for (int dx = -j; dx <= 0; dx++) {
+      int x = origin.x + dx * xx + dy * xy;
+      int y = origin.y + dx * yx + dy * yy;
+      float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+      float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+      if (start < rightSlope) continue;
+      if (end > leftSlope) break;
+
+      bool inside = InBounds(dungeon, x, y);
+      if (inside && dx * dx + dy * dy <= radius2) visit(x, y);
+
+      bool opaque = !inside || HasTileFlag(dungeon, x, y, kTileOpaque);
+      if (blocked) {
+        if (opaque) {
+          newStart = rightSlope;
+          continue;
+        }
+        blocked = false;
+        start = newStart;
+      } else if (opaque && j < radius) {
+        blocked = true;
+        CastOctant(dungeon, origin, radius, j + 1, start, leftSlope, xx, xy,
+                   yx, yy, visit);
+        newStart = rightSlope;
+      }
+    }
+    if (blocked) break;
+  }
+}
+
+template <typename Visit>
+void ComputeFov(const Dungeon &dungeon, GridPos origin, int radius,
+                Visit visit) {
+  static const int mult[4][8] = {{1, 0, 0, -1, -1, 0, 0, 1},
+                                 {0, 1, -1, 0, 0, -1, 1, 0},
+                                 {0, 1, 1, 0, 0, -1, -1, 0},
+                                 {1, 0, 0, 1, -1, 0, 0, -1}};
+  if (!InBounds(dungeon, origin.x, origin.y)) return;
+  visit(origin.x, origin.y);
+  for (int oct = 0; oct < 8; oct++) {
+    CastOctant(dungeon, origin, radius, 1, 1.0f, 0.0f, mult[0][oct],
+               mult[1][oct], mult[2][oct], mult[3][oct], visit);
+  }
+}
@@ -3,7 +3,7 @@
 #include <algorithm>
 #include <cmath>
 
-static void UpdateLayout(Game &game, int screenWidth, int screenHeight) {
+void ResizeGame(Game &game, int screenWidth, int screenHeight) {
   game.screenWidth = screenWidth;
   game.screenHeight = screenHeight;
 
@@ -14,50 +14,82 @@ static void UpdateLayout(Game &game, int screenWidth, int screenHeight) {
   int tile = (int)std::floor(std::min(availW / 32.0f, availH / 24.0f));
   if (tile < 12) tile = 12;
   if (tile > 40) tile = 40;
+  int cols = std::max(1, std::min(game.config.mapWidth, (int)(availW / tile)));
+  int rows = std::max(1, std::min(game.config.mapHeight, (int)(availH / tile)));
 
   game.tileSize = tile;
-  float dungeonW = game.tileSize * 32.0f;
-  float dungeonH = game.tileSize * 24.0f;
+  float dungeonW = (float)game.tileSize * cols;
+  float dungeonH = (float)game.tileSize * rows;
   float dungeonX = (screenWidth - dungeonW) * 0.5f;
   float dungeonY = uiHeight +
                    std::max(0.0f, (screenHeight - uiHeight - dungeonH) * 0.5f);
-  game.dungeonRect = Rectangle{dungeonX, dungeonY, dungeonW, dungeonH};
-  game.uiRect = Rectangle{0, 0, (float)screenWidth, uiHeight};
+  game.dungeonRect = Rect{dungeonX, dungeonY, dungeonW, dungeonH};
+  game.uiRect = Rect{0, 0, (float)screenWidth, uiHeight};
 }
 
-void InitGame(Game &game, int screenWidth, int screenHeight) {
+GameConfig DefaultGameConfig(uint64_t seed) {
+  GameConfig config;
+  config.seed = seed;
+  config.mapWidth = 32;
+  config.mapHeight = 24;
+  config.enemyDamage[0] = 2;
+  config.enemyDamage[1] = 3;
+  config.enemySpeed[0] = 100;
+  config.enemySpeed[1] = 100;
+  config.sleepingEnemies = false;
+  config.generator = GenerateMode::Auto;
+  return config;
+}
+
+void InitGame(Game &game, const GameConfig &config, int screenWidth,
+              int screenHeight) {
+  game.config = config;
+  game.config.mapWidth = std::max(16, std::min(2048, config.mapWidth));
+  game.config.mapHeight = std::max(16, std::min(2048, config.mapHeight));
+  for (int type = 0; type < kEnemyTypes; type++) {
+    game.config.enemySpeed[type] =
+        std::max(1, std::min(kMaxSpeed, config.enemySpeed[type]));
+  }
   game.mode = GameMode::Title;
-  UpdateLayout(game, screenWidth, screenHeight);
+  ResizeGame(game, screenWidth, screenHeight);
   game.animTime = 0.12f;
+  game.fovRadius = 6;
+  game.mapRevision = 0;
   game.shake = 0.0f;
-  ResetInput(game.input);
+  game.shakeX = 0;
+  game.shakeY = 0;
+  game.floorRng = MakeRng(config.seed, RngStream::Floor);
+  game.nextFloorSeed = RandomValue(game.floorRng, 1, 999999);
+  DiscardPendingFloor(game);
+  game.combatRng = MakeRng(config.seed, RngStream::Combat);
+  game.cosmeticRng = MakeRng(config.seed, RngStream::Cosmetic);
   ResetGame(game);
 }
 
-void UpdateGame(Game &game, float dt) {
-  int width = GetScreenWidth();
-  int height = GetScreenHeight();
-  if (width != game.screenWidth || height != game.screenHeight) {
-    UpdateLayout(game, width, height);
-  }
+bool AcceptsAction(const Game &game, float dt) {
+  const Actor &actor = game.player.actor;
+  return game.mode != GameMode::Playing || actor.moveT >= 1.0f ||
+         actor.moveT + dt / game.animTime >= 1.0f;
+}
 
-  InputAction action = ReadInput(game.input, dt);
+void UpdateGame(Game &game, const InputAction &action, float dt) {
   UpdateActors(game, dt);
 
-  for (auto &line : game.log) line.ttl -= dt;
-  game.log.erase(std::remove_if(game.log.begin(), game.log.end(),
-                                [](const LogLine &line) {
-                                  return line.ttl <= 0.0f;
-                                }),
-                 game.log.end());
+  AdvanceLog(game.log, dt);
 
   if (game.shake > 0.0f) game.shake = std::max(0.0f, game.shake - dt);
+  game.shakeX = 0;
+  game.shakeY = 0;
+  if (game.shake > 0.0f) {
+    game.shakeX = RandomValue(game.cosmeticRng, -2, 2);
+    game.shakeY = RandomValue(game.cosmeticRng, -2, 2);
+  }
   UpdateVisibility(game);
 
   if (game.mode == GameMode::Title) {
     if (action.confirm) {
       game.mode = GameMode::Playing;
-      AddLog(game, "Press H to use a potion.");
+      AddLog(game, LogMsg::PotionHint);
     }
     return;
   }
@@ -70,21 +102,25 @@ void UpdateGame(Game &game, float dt) {
     return;
   }
 
+  if (action.skipAnim) {
+    game.player.actor.moveT = 1.0f;
+    AdvanceEnemyMoves(game.enemies, 1.0f);
+  }
   if (game.player.actor.moveT < 1.0f) return;
 
   bool acted = false;
   if (action.usePotion) {
     if (game.player.potions > 0 && game.player.hp < game.player.maxHp) {
       game.player.potions--;
-      int heal = GetRandomValue(5, 9);
+      int heal = RandomValue(game.combatRng, 5, 9);
       game.player.hp = std::min(game.player.maxHp, game.player.hp + heal);
-      AddLog(game, "You drink a potion.");
+      AddLog(game, LogMsg::DrinkPotion);
       acted = true;
     } else {
-      AddLog(game, "No potions to use.");
+      AddLog(game, LogMsg::NoPotions);
     }
   } else if (action.wait) {
-    AddLog(game, "You hold position.");
+    AddLog(game, LogMsg::HoldPosition);
     acted = true;
   } else if (action.dx != 0 || action.dy != 0) {
     acted = HandleMove(game, action.dx, action.dy);
@@ -95,14 +131,14 @@ void UpdateGame(Game &game, float dt) {
   game.turn++;
   if (game.player.actor.cell == game.dungeon.exit) {
     game.floor++;
-    AddLog(game, "You descend deeper...");
-    BuildFloor(game, GetRandomValue(1, 999999));
+    AddLog(game, LogMsg::Descend);
+    AdvanceFloor(game);
     return;
   }
 
   EnemyTurn(game);
   if (game.player.hp <= 0) {
     game.mode = GameMode::GameOver;
-    AddLog(game, "You fall in the dark.");
+    AddLog(game, LogMsg::Fall);
   }
 }
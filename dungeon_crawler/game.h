@@ -1,35 +1,89 @@
 #pragma once
 
+#include "bitplane.h"
 #include "dungeon.h"
+#include "enemy_pool.h"
+#include "flowfield.h"
 #include "input.h"
+#include "message_log.h"
+#include "rng.h"
+#include "scheduler.h"
 #include "types.h"
 
-#include <raylib.h>
-
 #include <cstdint>
+#include <future>
 #include <vector>
 
+struct GameConfig {
+  uint64_t seed;
+  int mapWidth;
+  int mapHeight;
+  int enemyDamage[kEnemyTypes];
+  int enemySpeed[kEnemyTypes];
+  bool sleepingEnemies;
+  GenerateMode generator;
+};
+
+struct OccupancyGrid {
+  std::vector<int32_t> enemies;
+  std::vector<int32_t> items;
+};
+
+struct FloorBuild {
+  Dungeon dungeon;
+  EnemyPool enemies;
+  std::vector<Item> items;
+  OccupancyGrid occupancy;
+  BitPlane visible;
+  FlowField flow;
+  int openTiles;
+};
+
 struct Game {
+  GameConfig config;
   GameMode mode;
   int screenWidth;
   int screenHeight;
   int tileSize;
-  Rectangle dungeonRect;
-  Rectangle uiRect;
+  Rect dungeonRect;
+  Rect uiRect;
   float animTime;
 
   Dungeon dungeon;
   Player player;
-  std::vector<Enemy> enemies;
+  EnemyPool enemies;
+  TurnScheduler scheduler;
   std::vector<Item> items;
-  std::vector<LogLine> log;
-  std::vector<uint8_t> visible;
-  InputState input;
+  OccupancyGrid occupancy;
+  FlowField flow;
+  MessageLog log;
+  BitPlane visible;
+  int fovRadius;
+  bool fovDirty;
+  GridPos fovOrigin;
+  TileRect fovBox;
+  int mapRevision;
+  int exploredTiles;
+  int openTiles;
+  int exploredPct;
+
+  Rng floorRng;
+  int nextFloorSeed;
+  std::future<FloorBuild> pendingFloor;
+  Rng combatRng;
+  Rng cosmeticRng;
 
   int turn;
   int floor;
   float shake;
+  int shakeX;
+  int shakeY;
+  int lastHitBy;
 };
 
-void InitGame(Game &game, int screenWidth, int screenHeight);
-void UpdateGame(Game &game, float dt);
+GameConfig DefaultGameConfig(uint64_t seed);
+void InitGame(Game &game, const GameConfig &config, int screenWidth,
+              int screenHeight);
+void ResizeGame(Game &game, int screenWidth, int screenHeight);
+void UpdateGame(Game &game, const InputAction &action, float dt);
+bool AcceptsAction(const Game &game, float dt);
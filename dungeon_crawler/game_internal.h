@@ -2,12 +2,27 @@
 
 #include "game.h"
 
-#include <string>
-
 void ResetGame(Game &game);
-void BuildFloor(Game &game, int seed);
+void AdvanceFloor(Game &game);
+void StartNextFloor(Game &game);
+void DiscardPendingFloor(Game &game);
+void RestoreFloor(Game &game);
 void UpdateActors(Game &game, float dt);
 void UpdateVisibility(Game &game);
-void AddLog(Game &game, const std::string &text, float ttl = 7.0f);
+void AddLog(Game &game, LogMsg msg, int arg = 0, float ttl = 7.0f);
 bool HandleMove(Game &game, int dx, int dy);
 void EnemyTurn(Game &game);
+
+inline int CellIndex(const Game &game, GridPos cell) {
+  return TileIndex(game.dungeon, cell.x, cell.y);
+}
+
+inline bool IsOccupied(const Game &game, GridPos cell) {
+  if (game.player.actor.cell == cell) return true;
+  return game.occupancy.enemies[CellIndex(game, cell)] != 0;
+}
+
+inline Item *ItemAt(Game &game, GridPos cell) {
+  int slot = game.occupancy.items[CellIndex(game, cell)];
+  return slot > 0 ? &game.items[slot - 1] : nullptr;
+}
@@ -1,7 +1,10 @@
 #include "game_internal.h"
-#include <raylib.h>
+#include "fov.h"
+#include "profiler.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <thread>
 static int Sign(int v) {
   return (v > 0) - (v < 0);
 }
@@ -15,92 +18,203 @@ static void UpdateActor(Actor &actor, float dt, float animTime) {
   actor.moveT += dt / animTime;
   if (actor.moveT > 1.0f) actor.moveT = 1.0f;
 }
-static Enemy *EnemyAt(Game &game, GridPos cell) {
-  for (auto &enemy : game.enemies) {
-    if (enemy.hp > 0 && enemy.actor.cell == cell) return &enemy;
-  }
-  return nullptr;
+static int EnemyAt(const Game &game, GridPos cell) {
+  return game.occupancy.enemies[CellIndex(game, cell)] - 1;
 }
-static bool IsOccupied(const Game &game, GridPos cell) {
-  if (game.player.actor.cell == cell) return true;
-  for (const auto &enemy : game.enemies) {
-    if (enemy.hp > 0 && enemy.actor.cell == cell) return true;
-  }
-  return false;
+static void MoveEnemy(Game &game, int index, GridPos next) {
+  EnemyPool &pool = game.enemies;
+  int32_t &from = game.occupancy.enemies[CellIndex(game, pool.cell[index])];
+  game.occupancy.enemies[CellIndex(game, next)] = from;
+  from = 0;
+  pool.prev[index] = pool.cell[index];
+  pool.cell[index] = next;
+  pool.moveT[index] = 0.0f;
 }
-static Item *ItemAt(Game &game, GridPos cell) {
-  for (auto &item : game.items) {
-    if (!item.picked && item.cell == cell) return &item;
+static void KillEnemy(Game &game, int index) {
+  EnemyPool &pool = game.enemies;
+  game.occupancy.enemies[CellIndex(game, pool.cell[index])] = 0;
+  RemoveEnemy(pool, index);
+  if (index < EnemyCount(pool)) {
+    game.occupancy.enemies[CellIndex(game, pool.cell[index])] = index + 1;
   }
-  return nullptr;
 }
-void AddLog(Game &game, const std::string &text, float ttl) {
-  game.log.push_back(LogLine{text, ttl});
-  if (game.log.size() > 6) game.log.erase(game.log.begin());
+void AddLog(Game &game, LogMsg msg, int arg, float ttl) {
+  PushLog(game.log, msg, arg, ttl);
 }
 void UpdateActors(Game &game, float dt) {
+  PROFILE_ZONE(Actors);
   UpdateActor(game.player.actor, dt, game.animTime);
-  for (auto &enemy : game.enemies) UpdateActor(enemy.actor, dt, game.animTime);
+  AdvanceEnemyMoves(game.enemies, dt / game.animTime);
+}
+
+static TileRect ClampRect(const Dungeon &dungeon, TileRect rect) {
+  int x0 = std::max(0, rect.x);
+  int y0 = std::max(0, rect.y);
+  int x1 = std::min(dungeon.width, rect.x + rect.w);
+  int y1 = std::min(dungeon.height, rect.y + rect.h);
+  return TileRect{x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
 }
 
 void UpdateVisibility(Game &game) {
-  int size = game.dungeon.width * game.dungeon.height;
-  if ((int)game.visible.size() != size) game.visible.assign(size, 0);
-  std::fill(game.visible.begin(), game.visible.end(), 0);
-  const int radius = 6;
+  PROFILE_ZONE(Visibility);
   GridPos p = game.player.actor.cell;
-  for (int y = p.y - radius; y <= p.y + radius; y++) {
-    for (int x = p.x - radius; x <= p.x + radius; x++) {
-      if (!InBounds(game.dungeon, x, y)) continue;
-      int dx = x - p.x;
-      int dy = y - p.y;
-      if (dx * dx + dy * dy > radius * radius) continue;
-      int idx = TileIndex(game.dungeon, x, y);
-      game.visible[idx] = 1;
-      game.dungeon.seen[idx] = 1;
-    }
+  if (!game.fovDirty && p == game.fovOrigin) return;
+  if (game.visible.width != game.dungeon.width ||
+      game.visible.height != game.dungeon.height) {
+    ResizeBitPlane(game.visible, game.dungeon.width, game.dungeon.height);
+    game.fovBox = TileRect{0, 0, 0, 0};
   }
+
+  const TileRect &old = game.fovBox;
+  ClearBitRows(game.visible, old.y, old.y + old.h);
+
+  int radius = game.fovRadius;
+  game.fovBox = ClampRect(game.dungeon, TileRect{p.x - radius, p.y - radius,
+                                                 radius * 2 + 1,
+                                                 radius * 2 + 1});
+  ComputeFov(game.dungeon, p, radius,
+             [&game](int x, int y) { SetBit(game.visible, x, y); });
+  const TileRect &box = game.fovBox;
+  game.exploredTiles += CountNewBits(game.dungeon.seen, game.visible,
+                                     game.dungeon.open, box.y, box.y + box.h);
+  UnionBitRows(game.dungeon.seen, game.visible, box.y, box.y + box.h);
+  game.exploredPct =
+      game.openTiles > 0 ? game.exploredTiles * 100 / game.openTiles : 0;
+  game.fovOrigin = p;
+  game.fovDirty = false;
 }
-static GridPos FindFreeCell(const Game &game, const Room &room) {
+static bool IsFreeCell(const FloorBuild &floor, GridPos cell) {
+  int idx = TileIndex(floor.dungeon, cell.x, cell.y);
+  return !(cell == floor.dungeon.rooms.front().Center()) &&
+         floor.occupancy.enemies[idx] == 0 && floor.occupancy.items[idx] == 0;
+}
+static bool FindFreeCell(const FloorBuild &floor, const Room &room, Rng &rng,
+                         GridPos &out) {
   for (int i = 0; i < 20; i++) {
-    GridPos cell = RandomFloorInRoom(game.dungeon, room);
-    if (!IsOccupied(game, cell) && !(cell == game.dungeon.exit)) return cell;
+    GridPos cell = RandomFloorInRoom(floor.dungeon, room, rng);
+    if (IsFreeCell(floor, cell) && !(cell == floor.dungeon.exit)) {
+      out = cell;
+      return true;
+    }
   }
-  return room.Center();
-}
-static void PopulateDungeon(Game &game) {
-  game.enemies.clear();
-  game.items.clear();
-  for (size_t i = 1; i < game.dungeon.rooms.size(); i++) {
-    const Room &room = game.dungeon.rooms[i];
-    int enemyCount = GetRandomValue(1, 3);
+  out = room.Center();
+  return IsFreeCell(floor, out);
+}
+static void PopulateDungeon(FloorBuild &floor, const GameConfig &config,
+                            Rng &rng) {
+  Dungeon &dungeon = floor.dungeon;
+  ClearEnemies(floor.enemies);
+  floor.items.clear();
+  int size = dungeon.width * dungeon.height;
+  floor.occupancy.enemies.assign(size, 0);
+  floor.occupancy.items.assign(size, 0);
+  for (size_t i = 1; i < dungeon.rooms.size(); i++) {
+    const Room &room = dungeon.rooms[i];
+    int enemyCount = RandomValue(rng, 1, 3);
     for (int e = 0; e < enemyCount; e++) {
-      Enemy enemy;
-      enemy.actor.cell = FindFreeCell(game, room);
-      enemy.actor.prev = enemy.actor.cell;
-      enemy.actor.moveT = 1.0f;
-      enemy.type = GetRandomValue(0, 1);
-      enemy.hp = enemy.type == 0 ? 5 : 7;
-      game.enemies.push_back(enemy);
+      GridPos cell;
+      if (!FindFreeCell(floor, room, rng, cell)) continue;
+      int type = RandomValue(rng, 0, 1);
+      int index = SpawnEnemy(floor.enemies, cell, type, type == 0 ? 5 : 7,
+                             config.enemySpeed[type]);
+      floor.enemies.awake[index] = !config.sleepingEnemies;
+      floor.occupancy.enemies[TileIndex(dungeon, cell.x, cell.y)] = index + 1;
     }
-    if (GetRandomValue(0, 100) < 70) {
+    if (RandomValue(rng, 0, 100) < 70) {
       Item item;
-      item.cell = FindFreeCell(game, room);
-      item.type = GetRandomValue(0, 100) < 40 ? ItemType::Potion : ItemType::Gold;
-      item.amount = item.type == ItemType::Potion ? 1 : GetRandomValue(5, 14);
+      bool placed = FindFreeCell(floor, room, rng, item.cell);
+      item.type =
+          RandomValue(rng, 0, 100) < 40 ? ItemType::Potion : ItemType::Gold;
+      item.amount =
+          item.type == ItemType::Potion ? 1 : RandomValue(rng, 5, 14);
       item.picked = false;
-      game.items.push_back(item);
+      if (!placed) continue;
+      floor.items.push_back(item);
+      SetTileFlag(dungeon, item.cell, kTileItem, true);
+      floor.occupancy.items[TileIndex(dungeon, item.cell.x, item.cell.y)] =
+          (int32_t)floor.items.size();
     }
   }
 }
-void BuildFloor(Game &game, int seed) {
-  game.dungeon = GenerateDungeon(32, 24, seed);
-  game.dungeon.exit = game.dungeon.rooms.back().Center();
-  game.visible.assign(game.dungeon.width * game.dungeon.height, 0);
+static const int kPursuitRadius = 40;
+static FloorBuild MakeFloor(GameConfig config, int seed) {
+  FloorBuild floor;
+  floor.dungeon = GenerateDungeon(config.mapWidth, config.mapHeight, seed,
+                                  config.generator);
+  const Dungeon &dungeon = floor.dungeon;
+  floor.openTiles = CountBits(dungeon.open);
+  ResizeBitPlane(floor.visible, dungeon.width, dungeon.height);
+  ResetFlowField(floor.flow, dungeon.width, dungeon.height, kPursuitRadius);
+  Rng rng = MakeRng((uint64_t)seed, RngStream::Populate);
+  PopulateDungeon(floor, config, rng);
+  return floor;
+}
+static void BeginFloor(Game &game) {
+  game.fovBox = TileRect{0, 0, 0, 0};
+  game.fovDirty = true;
+  game.mapRevision++;
+  game.scheduler.heap.clear();
+}
+void DiscardPendingFloor(Game &game) {
+  std::future<FloorBuild> &pending = game.pendingFloor;
+  if (!pending.valid()) return;
+  auto ready = pending.wait_for(std::chrono::seconds(0));
+  if (ready == std::future_status::ready) {
+    pending = std::future<FloorBuild>();
+    return;
+  }
+  std::thread([stale = std::move(pending)]() mutable { stale.wait(); })
+      .detach();
+}
+void StartNextFloor(Game &game) {
+  DiscardPendingFloor(game);
+  game.pendingFloor = std::async(std::launch::async, MakeFloor, game.config,
+                                 game.nextFloorSeed);
+}
+void AdvanceFloor(Game &game) {
+  FloorBuild floor = game.pendingFloor.valid() ? game.pendingFloor.get()
+                                               : MakeFloor(game.config,
+                                                           game.nextFloorSeed);
+  std::swap(game.dungeon, floor.dungeon);
+  std::swap(game.enemies, floor.enemies);
+  std::swap(game.items, floor.items);
+  std::swap(game.occupancy, floor.occupancy);
+  std::swap(game.visible, floor.visible);
+  std::swap(game.flow, floor.flow);
+  game.openTiles = floor.openTiles;
+  game.exploredTiles = 0;
+  BeginFloor(game);
+  for (int i = 0; i < EnemyCount(game.enemies); i++) {
+    if (!game.enemies.awake[i]) continue;
+    ScheduleEnemy(game.scheduler, game.enemies, i, game.scheduler.now);
+  }
   game.player.actor.cell = game.dungeon.rooms.front().Center();
   game.player.actor.prev = game.player.actor.cell;
   game.player.actor.moveT = 1.0f;
-  PopulateDungeon(game);
+  UpdateVisibility(game);
+
+  game.nextFloorSeed = RandomValue(game.floorRng, 1, 999999);
+  StartNextFloor(game);
+}
+void RestoreFloor(Game &game) {
+  ResizeBitPlane(game.visible, game.dungeon.width, game.dungeon.height);
+  game.openTiles = CountBits(game.dungeon.open);
+  ResetFlowField(game.flow, game.dungeon.width, game.dungeon.height,
+                 kPursuitRadius);
+  BeginFloor(game);
+  int size = game.dungeon.width * game.dungeon.height;
+  game.occupancy.enemies.assign(size, 0);
+  game.occupancy.items.assign(size, 0);
+  for (int i = 0; i < EnemyCount(game.enemies); i++) {
+    game.occupancy.enemies[CellIndex(game, game.enemies.cell[i])] = i + 1;
+  }
+  RestoreSchedule(game.scheduler, game.enemies);
+  for (size_t i = 0; i < game.items.size(); i++) {
+    const Item &item = game.items[i];
+    if (item.picked) continue;
+    game.occupancy.items[CellIndex(game, item.cell)] = (int32_t)(i + 1);
+    SetTileFlag(game.dungeon, item.cell, kTileItem, true);
+  }
   UpdateVisibility(game);
 }
 void ResetGame(Game &game) {
@@ -112,76 +226,121 @@ void ResetGame(Game &game) {
   game.player.gold = 0;
   game.player.attack = 4;
   game.player.defense = 1;
-  game.log.clear();
-  AddLog(game, "You enter the crypt...");
-  BuildFloor(game, GetRandomValue(1, 999999));
+  ResetScheduler(game.scheduler);
+  game.lastHitBy = -1;
+  ClearLog(game.log);
+  AddLog(game, LogMsg::EnterCrypt);
+  AdvanceFloor(game);
 }
-void EnemyTurn(Game &game) {
+static void EnemyStrike(Game &game, int type) {
+  int damage = game.config.enemyDamage[type];
+  game.lastHitBy = type;
+  damage = std::max(1, damage - game.player.defense);
+  game.player.hp -= damage;
+  game.shake = 0.2f;
+  AddLog(game, LogMsg::EnemyStrike, damage);
+}
+static bool CanStep(const Game &game, GridPos cell) {
+  return IsWalkable(game.dungeon, cell.x, cell.y) && !IsOccupied(game, cell);
+}
+static bool GreedyStep(const Game &game, GridPos epos, int dx, int dy,
+                       GridPos &target) {
+  int stepX = Sign(dx);
+  int stepY = Sign(dy);
+  target = epos;
+  if (std::abs(dx) >= std::abs(dy)) target.x += stepX;
+  else target.y += stepY;
+  if (CanStep(game, target)) return true;
+  if (stepX == 0 || stepY == 0) return false;
+  target = GridPos{epos.x, epos.y + stepY};
+  return CanStep(game, target);
+}
+static bool FlowStep(const Game &game, GridPos epos, int dx, int dy,
+                     GridPos &target) {
+  int best = FlowDistance(game.flow, epos);
+  if (best < 0) return false;
+  int stepX = dx >= 0 ? 1 : -1;
+  int stepY = dy >= 0 ? 1 : -1;
+  GridPos order[4] = {{epos.x + stepX, epos.y}, {epos.x, epos.y + stepY},
+                      {epos.x, epos.y - stepY}, {epos.x - stepX, epos.y}};
+  if (std::abs(dx) < std::abs(dy)) std::swap(order[0], order[1]);
+  bool found = false;
+  for (const auto &next : order) {
+    if (!CanStep(game, next)) continue;
+    int d = FlowDistance(game.flow, next);
+    if (d < 0 || d >= best) continue;
+    best = d;
+    target = next;
+    found = true;
+  }
+  return found;
+}
+static void WakeEnemies(Game &game) {
+  EnemyPool &pool = game.enemies;
+  ForEachSetBit(game.visible, game.fovBox, [&](int x, int y) {
+    int index = game.occupancy.enemies[TileIndex(game.dungeon, x, y)] - 1;
+    if (index < 0 || pool.awake[index]) return;
+    pool.awake[index] = 1;
+    ScheduleEnemy(game.scheduler, pool, index, game.scheduler.now);
+  });
+}
+static void EnemyAct(Game &game, int index) {
   GridPos playerCell = game.player.actor.cell;
-  for (auto &enemy : game.enemies) {
-    if (enemy.hp <= 0) continue;
-    GridPos epos = enemy.actor.cell;
-    int dx = playerCell.x - epos.x;
-    int dy = playerCell.y - epos.y;
-    int dist = std::abs(dx) + std::abs(dy);
-    if (dist <= 1) {
-      int damage = enemy.type == 0 ? 2 : 3;
-      damage = std::max(1, damage - game.player.defense);
-      game.player.hp -= damage;
-      game.shake = 0.2f;
-      AddLog(game, "An enemy strikes you for " + std::to_string(damage) + "!");
-      continue;
-    }
-    if (dist > 7 && GetRandomValue(0, 100) < 50) continue;
-    int stepX = Sign(dx);
-    int stepY = Sign(dy);
-    GridPos target = epos;
-    if (std::abs(dx) >= std::abs(dy)) target.x += stepX;
-    else target.y += stepY;
-    if (target == playerCell) {
-      int damage = enemy.type == 0 ? 2 : 3;
-      damage = std::max(1, damage - game.player.defense);
-      game.player.hp -= damage;
-      game.shake = 0.2f;
-      AddLog(game, "An enemy strikes you for " + std::to_string(damage) + "!");
-      continue;
-    }
-    bool blocked = !IsWalkable(game.dungeon, target.x, target.y) ||
-                   IsOccupied(game, target);
-    if (blocked && stepX != 0 && stepY != 0) {
-      GridPos alt = epos;
-      alt.y += stepY;
-      if (IsWalkable(game.dungeon, alt.x, alt.y) && !IsOccupied(game, alt)) {
-        target = alt;
-        blocked = false;
-      }
-    }
-
-    if (!blocked) StartMove(enemy.actor, target);
+  GridPos epos = game.enemies.cell[index];
+  int dx = playerCell.x - epos.x;
+  int dy = playerCell.y - epos.y;
+  int dist = std::abs(dx) + std::abs(dy);
+  if (dist <= 1) {
+    EnemyStrike(game, game.enemies.type[index]);
+    return;
+  }
+  if (dist > 7 && RandomValue(game.combatRng, 0, 100) < 50) return;
+  GridPos target;
+  bool moved = FlowDistance(game.flow, epos) >= 0
+                   ? FlowStep(game, epos, dx, dy, target)
+                   : GreedyStep(game, epos, dx, dy, target);
+  if (moved) MoveEnemy(game, index, target);
+}
+void EnemyTurn(Game &game) {
+  PROFILE_ZONE(Enemies);
+  UpdateFlowField(game.flow, game.dungeon, game.player.actor.cell);
+  if (game.config.sleepingEnemies) WakeEnemies(game);
+  TurnScheduler &scheduler = game.scheduler;
+  EnemyPool &pool = game.enemies;
+  scheduler.now += kActionCost;
+  int index;
+  while (PopDueEnemy(scheduler, pool, index)) {
+    EnemyAct(game, index);
+    ScheduleEnemy(scheduler, pool, index,
+                  pool.nextTurn[index] + ActionDelay(pool.speed[index]));
   }
 }
 bool HandleMove(Game &game, int dx, int dy) {
   GridPos next{game.player.actor.cell.x + dx, game.player.actor.cell.y + dy};
   if (!IsWalkable(game.dungeon, next.x, next.y)) return false;
-  if (Enemy *enemy = EnemyAt(game, next)) {
-    int damage = game.player.attack + GetRandomValue(0, 2);
-    enemy->hp -= damage;
-    AddLog(game, "You hit for " + std::to_string(damage) + ".");
-    if (enemy->hp <= 0) {
-      AddLog(game, "Enemy defeated.");
-      game.player.gold += GetRandomValue(2, 6);
+  int target = EnemyAt(game, next);
+  if (target >= 0) {
+    int damage = game.player.attack + RandomValue(game.combatRng, 0, 2);
+    game.enemies.hp[target] -= damage;
+    AddLog(game, LogMsg::PlayerHit, damage);
+    if (game.enemies.hp[target] <= 0) {
+      KillEnemy(game, target);
+      AddLog(game, LogMsg::EnemyDefeated);
+      game.player.gold += RandomValue(game.combatRng, 2, 6);
     }
     return true;
   }
   StartMove(game.player.actor, next);
   if (Item *item = ItemAt(game, next)) {
     item->picked = true;
+    game.occupancy.items[CellIndex(game, next)] = 0;
+    SetTileFlag(game.dungeon, next, kTileItem, false);
     if (item->type == ItemType::Gold) {
       game.player.gold += item->amount;
-      AddLog(game, "Picked up " + std::to_string(item->amount) + " gold.");
+      AddLog(game, LogMsg::PickGold, item->amount);
     } else {
       game.player.potions += item->amount;
-      AddLog(game, "Found a potion.");
+      AddLog(game, LogMsg::FindPotion);
     }
   }
   return true;
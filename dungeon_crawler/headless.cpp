@@ -0,0 +1,197 @@
+#include "action_queue.h"
+#include "game.h"
+#include "profiler.h"
+#include "replay.h"
+#include "savegame.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct ActionStream {
+  uint64_t state;
+};
+
+static uint32_t NextAction(ActionStream &stream) {
+  stream.state ^= stream.state << 13;
+  stream.state ^= stream.state >> 7;
+  stream.state ^= stream.state << 17;
+  return (uint32_t)(stream.state >> 32);
+}
+
+static InputAction ScriptedAction(ActionStream &stream, const Game &game) {
+  InputAction action = {};
+  if (game.mode != GameMode::Playing) {
+    action.confirm = true;
+    return action;
+  }
+  uint32_t roll = NextAction(stream) % 100;
+  if (roll < 3) {
+    action.usePotion = true;
+  } else if (roll < 8) {
+    action.wait = true;
+  } else {
+    static const int dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    int dir = (int)(NextAction(stream) % 4);
+    action.dx = dirs[dir][0];
+    action.dy = dirs[dir][1];
+  }
+  return action;
+}
+
+static uint64_t Mix(uint64_t hash, uint64_t v) {
+  hash ^= v;
+  return hash * 0x100000001b3ULL;
+}
+
+static uint64_t GameChecksum(const Game &game) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hash = Mix(hash, (uint64_t)game.turn);
+  hash = Mix(hash, (uint64_t)game.floor);
+  hash = Mix(hash, (uint64_t)game.player.hp);
+  hash = Mix(hash, (uint64_t)game.player.gold);
+  hash = Mix(hash, (uint64_t)game.player.potions);
+  hash = Mix(hash, (uint64_t)game.player.actor.cell.x);
+  hash = Mix(hash, (uint64_t)game.player.actor.cell.y);
+  const EnemyPool &pool = game.enemies;
+  for (int i = 0; i < EnemyCount(pool); i++) {
+    hash = Mix(hash, (uint64_t)pool.hp[i]);
+    hash = Mix(hash, (uint64_t)pool.cell[i].x);
+    hash = Mix(hash, (uint64_t)pool.cell[i].y);
+  }
+  return hash;
+}
+
+int main(int argc, char **argv) {
+  GameConfig config = DefaultGameConfig(1);
+  long frames = 100000;
+  float dt = 0.05f;
+  const char *profilePath = nullptr;
+  const char *recordPath = nullptr;
+  const char *replayPath = nullptr;
+  const char *loadPath = nullptr;
+  const char *savePath = nullptr;
+  int lookahead = 0;
+  int skipDepth = 0;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      config.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--map") == 0 && i + 1 < argc &&
+               std::sscanf(argv[i + 1], "%dx%d", &config.mapWidth,
+                           &config.mapHeight) == 2) {
+      i++;
+    } else if (std::strcmp(argv[i], "--generator") == 0 && i + 1 < argc &&
+               ParseGenerateMode(argv[i + 1], config.generator)) {
+      i++;
+    } else if (std::strcmp(argv[i], "--enemy-speed") == 0 && i + 1 < argc &&
+               std::sscanf(argv[i + 1], "%d,%d", &config.enemySpeed[0],
+                           &config.enemySpeed[1]) == 2) {
+      i++;
+    } else if (std::strcmp(argv[i], "--sleeping") == 0 && i + 1 < argc) {
+      config.sleepingEnemies = std::atoi(argv[++i]) != 0;
+    } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = std::strtol(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc) {
+      dt = std::strtof(argv[++i], nullptr);
+    } else if (std::strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+      profilePath = argv[++i];
+    } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+      loadPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+      savePath = argv[++i];
+    } else if (std::strcmp(argv[i], "--queue") == 0 && i + 1 < argc) {
+      lookahead = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--skip-anim") == 0 && i + 1 < argc) {
+      skipDepth = std::atoi(argv[++i]);
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--seed N] [--map WxH] [--generator MODE] "
+                   "[--enemy-speed A,B] [--sleeping 0|1] [--frames N] "
+                   "[--dt seconds] [--profile-csv FILE] "
+                   "[--record FILE] [--replay FILE] [--load FILE] "
+                   "[--save FILE] [--queue N] [--skip-anim N]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  Replay replay;
+  ReplayCursor cursor{0, 0};
+  if (replayPath) {
+    if (!LoadReplay(replay, replayPath)) {
+      std::fprintf(stderr, "could not load replay: %s\n", replayPath);
+      return 1;
+    }
+    config = replay.config;
+    frames = (long)replay.frames;
+  } else {
+    BeginReplay(replay, config);
+  }
+
+  if (profilePath && !ProfOpenCsv(profilePath)) {
+    std::fprintf(stderr, "profiling unavailable: %s\n", profilePath);
+  }
+
+  Game game;
+  InitGame(game, config, 1280, 720);
+  if (loadPath && !LoadGame(game, loadPath)) {
+    std::fprintf(stderr, "could not load save: %s\n", loadPath);
+    return 1;
+  }
+  ActionStream stream{config.seed * 0x9e3779b97f4a7c15ULL + 1};
+  ActionQueue queue;
+  ResetActionQueue(queue, lookahead, skipDepth);
+
+  int deaths = 0;
+  int deepest = game.floor;
+  auto start = std::chrono::steady_clock::now();
+  int turns = 0;
+  for (long frame = 0; frame < frames; frame++) {
+    ProfBeginFrame();
+    InputAction action;
+    float frameDt = dt;
+    if (replayPath) {
+      NextReplayFrame(replay, cursor, action, frameDt);
+    } else {
+      PushAction(queue, ScriptedAction(stream, game));
+      action = PopAction(queue, game, frameDt);
+      if (recordPath) RecordFrame(replay, action, frameDt);
+    }
+    int turnBefore = game.turn;
+    GameMode modeBefore = game.mode;
+    UpdateGame(game, action, frameDt);
+    if (game.turn > turnBefore) turns += game.turn - turnBefore;
+    if (modeBefore == GameMode::Playing && game.mode == GameMode::GameOver) {
+      deaths++;
+    }
+    if (game.floor > deepest) deepest = game.floor;
+    ProfEndFrame();
+  }
+  ProfCloseCsv();
+  if (savePath && !SaveGame(game, savePath)) {
+    std::fprintf(stderr, "could not save game: %s\n", savePath);
+    return 1;
+  }
+  if (recordPath && !SaveReplay(replay, recordPath)) {
+    std::fprintf(stderr, "could not save replay: %s\n", recordPath);
+    return 1;
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  std::printf("frames    %ld\n", frames);
+  std::printf("turns     %d\n", turns);
+  std::printf("deaths    %d\n", deaths);
+  std::printf("deepest   %d\n", deepest);
+  std::printf("elapsed   %.3f ms\n", ms);
+  std::printf("turns/ms  %.1f\n", ms > 0.0 ? turns / ms : 0.0);
+  std::printf("checksum  %016llx\n", (unsigned long long)GameChecksum(game));
+  if (!replayPath) PrintLatencyStats(queue);
+  return 0;
+}
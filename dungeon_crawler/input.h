@@ -7,6 +7,7 @@ struct InputAction {
   bool usePotion;
   bool restart;
   bool confirm;
+  bool skipAnim;
 };
 
 struct InputState {
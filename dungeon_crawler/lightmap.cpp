@@ -0,0 +1,204 @@
+#include "lightmap.h"
+
+#include "fov.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const Color kAmbient{128, 124, 136, 255};
+static const Color kTorch{150, 96, 44, 0};
+static const Color kPlayerLight{110, 118, 120, 0};
+static const int kTorchRadius = 5;
+static const int kPlayerRadius = 7;
+
+void InitLightMap(LightMap &map) {
+  map = LightMap{};
+  map.mapRevision = -1;
+  map.loaded = false;
+}
+
+void UnloadLightMap(LightMap &map) {
+  if (map.loaded) UnloadTexture(map.texture);
+  map.loaded = false;
+}
+
+static bool SameLight(const LightSource &a, const LightSource &b) {
+  return a.cell == b.cell && a.radius == b.radius &&
+         a.color.r == b.color.r && a.color.g == b.color.g &&
+         a.color.b == b.color.b;
+}
+
+static bool SameLights(const std::vector<LightSource> &a,
+                       const std::vector<LightSource> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!SameLight(a[i], b[i])) return false;
+  }
+  return true;
+}
+
+static void CastLight(LightMap &map, const Dungeon &dungeon,
+                      std::vector<uint8_t> &layer, const LightSource &light,
+                      TileRect clip) {
+  const TileRect &area = map.area;
+  int reach = (light.radius + 1) * (light.radius + 1);
+  uint32_t id = ++map.stampId;
+  ComputeFov(dungeon, light.cell, light.radius, [&](int x, int y) {
+    if (x < clip.x || y < clip.y || x >= clip.x + clip.w ||
+        y >= clip.y + clip.h) {
+      return;
+    }
+    int idx = (y - area.y) * area.w + (x - area.x);
+    if (map.stamp[idx] == id) return;
+    map.stamp[idx] = id;
+    int dx = x - light.cell.x;
+    int dy = y - light.cell.y;
+    int weight = 256 - (dx * dx + dy * dy) * 256 / reach;
+    uint8_t *px = &layer[idx * 4];
+    px[0] = (uint8_t)std::min(255, px[0] + (light.color.r * weight >> 8));
+    px[1] = (uint8_t)std::min(255, px[1] + (light.color.g * weight >> 8));
+    px[2] = (uint8_t)std::min(255, px[2] + (light.color.b * weight >> 8));
+  });
+}
+
+static void BuildTorches(LightMap &map, const Dungeon &dungeon,
+                         TileRect clip) {
+  const TileRect &area = map.area;
+  for (int y = clip.y; y < clip.y + clip.h; y++) {
+    size_t row = ((size_t)(y - area.y) * area.w + (clip.x - area.x)) * 4;
+    std::memset(map.torchLayer.data() + row, 0, (size_t)clip.w * 4);
+  }
+  int x0 = clip.x - kTorchRadius;
+  int y0 = clip.y - kTorchRadius;
+  int x1 = clip.x + clip.w + kTorchRadius;
+  int y1 = clip.y + clip.h + kTorchRadius;
+  for (const Room &room : dungeon.rooms) {
+    GridPos cell{room.x + room.w / 2, room.y - 1};
+    if (cell.x < x0 || cell.y < y0 || cell.x >= x1 || cell.y >= y1) continue;
+    CastLight(map, dungeon, map.torchLayer,
+              LightSource{cell, kTorchRadius, kTorch}, clip);
+  }
+}
+
+static void ScrollTorches(LightMap &map, const Dungeon &dungeon,
+                          TileRect area) {
+  int dx = area.x - map.area.x;
+  int dy = area.y - map.area.y;
+  map.area = area;
+  if (std::abs(dx) >= area.w || std::abs(dy) >= area.h) {
+    BuildTorches(map, dungeon, area);
+    return;
+  }
+  uint8_t *layer = map.torchLayer.data();
+  size_t pitch = (size_t)area.w * 4;
+  size_t span = (size_t)(area.w - std::abs(dx)) * 4;
+  size_t dst = (size_t)std::max(0, -dx) * 4;
+  size_t src = (size_t)std::max(0, dx) * 4;
+  int rows = area.h - std::abs(dy);
+  int top = std::max(0, -dy);
+  for (int i = 0; i < rows; i++) {
+    int y = top + (dy >= 0 ? i : rows - 1 - i);
+    std::memmove(layer + y * pitch + dst, layer + (y + dy) * pitch + src,
+                 span);
+  }
+  if (dx != 0) {
+    int x = dx > 0 ? area.x + area.w - dx : area.x;
+    BuildTorches(map, dungeon, TileRect{x, area.y, std::abs(dx), area.h});
+  }
+  if (dy != 0) {
+    int y = dy > 0 ? area.y + area.h - dy : area.y;
+    BuildTorches(map, dungeon, TileRect{area.x, y, area.w, std::abs(dy)});
+  }
+}
+
+static void GatherLights(const Game &game, TileRect area,
+                         std::vector<LightSource> &lights) {
+  lights.clear();
+  lights.push_back(
+      LightSource{game.player.actor.cell, kPlayerRadius, kPlayerLight});
+  ForEachSetBit(game.visible, area, [&](int x, int y) {
+    int idx = TileIndex(game.dungeon, x, y);
+    int item = game.occupancy.items[idx];
+    if (item > 0 && game.items[item - 1].type == ItemType::Potion) {
+      lights.push_back(LightSource{GridPos{x, y}, 2, Color{90, 40, 110, 0}});
+    }
+    int enemy = game.occupancy.enemies[idx];
+    if (enemy > 0) {
+      Color glow = game.enemies.type[enemy - 1] == 0 ? Color{40, 80, 30, 0}
+                                                     : Color{110, 30, 20, 0};
+      lights.push_back(LightSource{GridPos{x, y}, 2, glow});
+    }
+  });
+}
+
+static void CombineLayers(LightMap &map) {
+  size_t count = map.pixels.size();
+  const uint8_t *torch = map.torchLayer.data();
+  const uint8_t *dynamic = map.dynamicLayer.data();
+  uint8_t *out = map.pixels.data();
+  uint8_t ambient[4] = {kAmbient.r, kAmbient.g, kAmbient.b, kAmbient.a};
+  size_t i = 0;
+#if defined(__SSE2__)
+  uint32_t packed;
+  std::memcpy(&packed, ambient, 4);
+  __m128i base = _mm_set1_epi32((int)packed);
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(torch + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(dynamic + i));
+    __m128i sum = _mm_adds_epu8(base, _mm_adds_epu8(a, b));
+    _mm_storeu_si128((__m128i *)(out + i), sum);
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = (uint8_t)std::min(255, ambient[i & 3] + torch[i] + dynamic[i]);
+  }
+}
+
+bool UpdateLightMap(LightMap &map, const Game &game, TileRect area) {
+  if (area.w <= 0 || area.h <= 0) return false;
+  bool remap = area.w != map.area.w || area.h != map.area.h ||
+               game.mapRevision != map.mapRevision;
+  bool moved = area.x != map.area.x || area.y != map.area.y;
+  GatherLights(game, area, map.gathered);
+  if (!remap && !moved && SameLights(map.gathered, map.lights)) return false;
+
+  if (remap) {
+    size_t bytes = (size_t)area.w * area.h * 4;
+    map.area = area;
+    map.mapRevision = game.mapRevision;
+    map.torchLayer.resize(bytes);
+    map.dynamicLayer.resize(bytes);
+    map.pixels.resize(bytes);
+    map.stamp.assign((size_t)area.w * area.h, 0);
+    map.stampId = 0;
+    BuildTorches(map, game.dungeon, area);
+  } else if (moved) {
+    ScrollTorches(map, game.dungeon, area);
+  }
+  map.lights.swap(map.gathered);
+  std::fill(map.dynamicLayer.begin(), map.dynamicLayer.end(), 0);
+  for (const LightSource &light : map.lights) {
+    CastLight(map, game.dungeon, map.dynamicLayer, light, area);
+  }
+  CombineLayers(map);
+
+  if (map.loaded && (map.texture.width != area.w ||
+                     map.texture.height != area.h)) {
+    UnloadTexture(map.texture);
+    map.loaded = false;
+  }
+  if (!map.loaded) {
+    Image image = GenImageColor(area.w, area.h, BLACK);
+    map.texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+    SetTextureFilter(map.texture, TEXTURE_FILTER_BILINEAR);
+    map.loaded = true;
+  }
+  UpdateTexture(map.texture, map.pixels.data());
+  return true;
+}
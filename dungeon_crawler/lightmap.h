@@ -0,0 +1,32 @@
+#pragma once
+
+#include "game.h"
+
+#include <raylib.h>
+
+#include <cstdint>
+#include <vector>
+
+struct LightSource {
+  GridPos cell;
+  int radius;
+  Color color;
+};
+
+struct LightMap {
+  TileRect area;
+  int mapRevision;
+  std::vector<LightSource> lights;
+  std::vector<LightSource> gathered;
+  std::vector<uint8_t> torchLayer;
+  std::vector<uint8_t> dynamicLayer;
+  std::vector<uint8_t> pixels;
+  std::vector<uint32_t> stamp;
+  uint32_t stampId;
+  Texture2D texture;
+  bool loaded;
+};
+
+void InitLightMap(LightMap &map);
+void UnloadLightMap(LightMap &map);
+bool UpdateLightMap(LightMap &map, const Game &game, TileRect area);
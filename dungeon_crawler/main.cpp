@@ -1,30 +1,162 @@
 #include <raylib.h>
 
+#include "action_queue.h"
 #include "game.h"
+#include "input.h"
+#include "profiler.h"
 #include "render.h"
+#include "replay.h"
+#include "savegame.h"
 
-int main() {
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+static void Usage(const char *exe) {
+  std::fprintf(stderr,
+               "usage: %s [--seed N] [--map WxH] [--generator MODE] "
+               "[--profile-csv FILE] [--record FILE] [--replay FILE] "
+               "[--save FILE] [--fps N] [--tick-rate N] [--queue N] "
+               "[--skip-anim N]\n",
+               exe);
+}
+
+int main(int argc, char **argv) {
   const int screenWidth = 1280;
   const int screenHeight = 720;
 
+  GameConfig config = DefaultGameConfig((uint64_t)std::time(nullptr));
+  const char *profilePath = nullptr;
+  const char *recordPath = nullptr;
+  const char *replayPath = nullptr;
+  const char *savePath = "cryptbound.sav";
+  int fps = 60;
+  int tickRate = 60;
+  int lookahead = 2;
+  int skipDepth = 2;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) {
+      Usage(argv[0]);
+      return 1;
+    }
+    i++;
+    bool ok = true;
+    if (std::strcmp(arg, "--seed") == 0) {
+      config.seed = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--map") == 0) {
+      ok = std::sscanf(value, "%dx%d", &config.mapWidth,
+                       &config.mapHeight) == 2;
+    } else if (std::strcmp(arg, "--generator") == 0) {
+      ok = ParseGenerateMode(value, config.generator);
+    } else if (std::strcmp(arg, "--profile-csv") == 0) {
+      profilePath = value;
+    } else if (std::strcmp(arg, "--record") == 0) {
+      recordPath = value;
+    } else if (std::strcmp(arg, "--replay") == 0) {
+      replayPath = value;
+    } else if (std::strcmp(arg, "--save") == 0) {
+      savePath = value;
+    } else if (std::strcmp(arg, "--fps") == 0) {
+      fps = std::atoi(value);
+    } else if (std::strcmp(arg, "--tick-rate") == 0) {
+      tickRate = std::max(1, std::atoi(value));
+    } else if (std::strcmp(arg, "--queue") == 0) {
+      lookahead = std::atoi(value);
+    } else if (std::strcmp(arg, "--skip-anim") == 0) {
+      skipDepth = std::atoi(value);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  Replay replay;
+  ReplayCursor cursor{0, 0};
+  bool playing = false;
+  if (replayPath) {
+    if (!LoadReplay(replay, replayPath)) {
+      std::fprintf(stderr, "could not load replay: %s\n", replayPath);
+      return 1;
+    }
+    config = replay.config;
+    playing = true;
+  } else {
+    BeginReplay(replay, config);
+  }
+
+  if (profilePath && !ProfOpenCsv(profilePath)) {
+    std::fprintf(stderr, "profiling unavailable: %s\n", profilePath);
+  }
+
   SetConfigFlags(FLAG_WINDOW_RESIZABLE);
   InitWindow(screenWidth, screenHeight, "Cryptbound - Roguelike Dungeon");
-  SetTargetFPS(60);
+  SetTargetFPS(fps);
 
   Game game;
-  InitGame(game, screenWidth, screenHeight);
+  InitGame(game, config, screenWidth, screenHeight);
+  InputState input;
+  ResetInput(input);
+  ActionQueue queue;
+  ResetActionQueue(queue, lookahead, skipDepth);
+  Renderer renderer;
+  InitRenderer(renderer);
 
+  const float tick = 1.0f / tickRate;
+  float accumulator = 0.0f;
   while (!WindowShouldClose()) {
-    float dt = GetFrameTime();
-    if (dt > 0.05f) dt = 0.05f;
-    UpdateGame(game, dt);
+    ProfBeginFrame();
+    float frameDt = std::min(GetFrameTime(), 0.25f);
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    if (width != game.screenWidth || height != game.screenHeight) {
+      ResizeGame(game, width, height);
+    }
+    {
+      PROFILE_ZONE(Input);
+      InputAction pressed = ReadInput(input, frameDt);
+      if (!playing) PushAction(queue, pressed);
+    }
+    accumulator += frameDt;
+    while (accumulator >= tick) {
+      accumulator -= tick;
+      InputAction action;
+      float dt = tick;
+      if (playing) playing = NextReplayFrame(replay, cursor, action, dt);
+      if (!playing) action = PopAction(queue, game, dt);
+      if (!playing && recordPath) RecordFrame(replay, action, dt);
+      UpdateGame(game, action, dt);
+    }
+    if (IsKeyPressed(KEY_F3)) renderer.showStats = !renderer.showStats;
+    if (IsKeyPressed(KEY_F4)) renderer.showProfiler = !renderer.showProfiler;
+    if (IsKeyPressed(KEY_F5)) {
+      bool ok = SaveGame(game, savePath);
+      PushLog(game.log, ok ? LogMsg::GameSaved : LogMsg::SaveFailed, 0, 7.0f);
+    }
+    if (IsKeyPressed(KEY_F9)) {
+      bool ok = LoadGame(game, savePath);
+      PushLog(game.log, ok ? LogMsg::GameLoaded : LogMsg::SaveFailed, 0, 7.0f);
+    }
 
     BeginDrawing();
     ClearBackground(BLACK);
-    DrawGame(game);
+    DrawGame(game, renderer, accumulator);
     EndDrawing();
+    ProfEndFrame();
   }
 
+  ProfCloseCsv();
+  if (recordPath && !SaveReplay(replay, recordPath)) {
+    std::fprintf(stderr, "could not save replay: %s\n", recordPath);
+  }
+  if (!replayPath) PrintLatencyStats(queue);
+  UnloadRenderer(renderer);
   CloseWindow();
   return 0;
 }
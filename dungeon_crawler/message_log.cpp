@@ -0,0 +1,57 @@
+#include "message_log.h"
+
+#include <cstdio>
+#include <cstring>
+
+static_assert((kLogCapacity & (kLogCapacity - 1)) == 0,
+              "log capacity must be a power of two");
+
+static const char *kLogText[(int)LogMsg::Count] = {
+    "You enter the crypt...",
+    "Press H to use a potion.",
+    "You drink a potion.",
+    "No potions to use.",
+    "You hold position.",
+    "You descend deeper...",
+    "You fall in the dark.",
+    "An enemy strikes you for %i!",
+    "You hit for %i.",
+    "Enemy defeated.",
+    "Picked up %i gold.",
+    "Found a potion.",
+    "Game saved.",
+    "Game loaded.",
+    "Could not access the save file.",
+};
+
+void ClearLog(MessageLog &log) {
+  std::memset(log.entries, 0, sizeof(log.entries));
+  log.count = 0;
+  log.clock = 0.0;
+}
+
+void PushLog(MessageLog &log, LogMsg msg, int arg, float ttl) {
+  LogEntry &entry = log.entries[log.count % kLogCapacity];
+  entry.expires = log.clock + ttl;
+  entry.arg = arg;
+  entry.msg = msg;
+  log.count++;
+}
+
+void AdvanceLog(MessageLog &log, float dt) {
+  log.clock += dt;
+}
+
+int ActiveLogLines(const MessageLog &log, int maxLines) {
+  int size = LogSize(log);
+  int lines = 0;
+  while (lines < maxLines && lines < size &&
+         LogLine(log, lines).expires > log.clock) {
+    lines++;
+  }
+  return lines;
+}
+
+int FormatLog(const LogEntry &entry, char *buffer, int size) {
+  return std::snprintf(buffer, size, kLogText[(int)entry.msg], entry.arg);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+enum class LogMsg : uint8_t {
+  EnterCrypt,
+  PotionHint,
+  DrinkPotion,
+  NoPotions,
+  HoldPosition,
+  Descend,
+  Fall,
+  EnemyStrike,
+  PlayerHit,
+  EnemyDefeated,
+  PickGold,
+  FindPotion,
+  GameSaved,
+  GameLoaded,
+  SaveFailed,
+  Count
+};
+
+struct LogEntry {
+  double expires;
+  int32_t arg;
+  LogMsg msg;
+};
+
+const int kLogCapacity = 64;
+
+struct MessageLog {
+  LogEntry entries[kLogCapacity];
+  uint32_t count;
+  double clock;
+};
+
+void ClearLog(MessageLog &log);
+void PushLog(MessageLog &log, LogMsg msg, int arg, float ttl);
+void AdvanceLog(MessageLog &log, float dt);
+int ActiveLogLines(const MessageLog &log, int maxLines);
+int FormatLog(const LogEntry &entry, char *buffer, int size);
+
+inline int LogSize(const MessageLog &log) {
+  return log.count < (uint32_t)kLogCapacity ? (int)log.count : kLogCapacity;
+}
+
+inline const LogEntry &LogLine(const MessageLog &log, int back) {
+  return log.entries[(log.count - 1 - back) % kLogCapacity];
+}
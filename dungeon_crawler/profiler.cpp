@@ -0,0 +1,115 @@
+#include "profiler.h"
+
+#ifdef CRYPT_PROFILE
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+struct ProfFrame {
+  float ms[(int)ProfZone::Count];
+};
+
+struct Profiler {
+  ProfFrame frames[kProfFrames];
+  ProfFrame current;
+  uint64_t frameStart;
+  uint32_t count;
+  FILE *csv;
+  char csvBuffer[1 << 16];
+};
+
+static thread_local Profiler profiler;
+
+static const char *kZoneNames[(int)ProfZone::Count] = {
+    "input", "actors", "visibility", "enemies", "draw", "ui", "frame"};
+
+static uint64_t NowNs() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now)
+      .count();
+}
+
+ProfScope::ProfScope(ProfZone zone) : zone(zone), start(NowNs()) {}
+
+ProfScope::~ProfScope() {
+  profiler.current.ms[(int)zone] += (NowNs() - start) * 1e-6f;
+}
+
+void ProfBeginFrame() {
+  profiler.current = ProfFrame{};
+  profiler.frameStart = NowNs();
+}
+
+void ProfEndFrame() {
+  ProfFrame &frame = profiler.current;
+  frame.ms[(int)ProfZone::Frame] = (NowNs() - profiler.frameStart) * 1e-6f;
+  profiler.frames[profiler.count % kProfFrames] = frame;
+  if (profiler.csv) {
+    std::fprintf(profiler.csv, "%u", profiler.count);
+    for (int i = 0; i < (int)ProfZone::Count; i++) {
+      std::fprintf(profiler.csv, ",%.4f", frame.ms[i]);
+    }
+    std::fputc('\n', profiler.csv);
+  }
+  profiler.count++;
+}
+
+bool ProfOpenCsv(const char *path) {
+  ProfCloseCsv();
+  profiler.csv = std::fopen(path, "w");
+  if (!profiler.csv) return false;
+  std::setvbuf(profiler.csv, profiler.csvBuffer, _IOFBF,
+               sizeof(profiler.csvBuffer));
+  std::fprintf(profiler.csv, "frame");
+  for (int i = 0; i < (int)ProfZone::Count; i++) {
+    std::fprintf(profiler.csv, ",%s_ms", kZoneNames[i]);
+  }
+  std::fputc('\n', profiler.csv);
+  return true;
+}
+
+void ProfCloseCsv() {
+  if (profiler.csv) std::fclose(profiler.csv);
+  profiler.csv = nullptr;
+}
+
+int ProfFrameCount() {
+  return std::min((int)profiler.count, kProfFrames);
+}
+
+ProfSummary ProfSummarize(ProfZone zone) {
+  static float samples[kProfFrames];
+  int n = ProfFrameCount();
+  ProfSummary summary = {};
+  if (n == 0) return summary;
+  float total = 0.0f;
+  for (int i = 0; i < n; i++) {
+    samples[i] = profiler.frames[i].ms[(int)zone];
+    total += samples[i];
+  }
+  std::sort(samples, samples + n);
+  summary.avg = total / n;
+  summary.p50 = samples[n / 2];
+  summary.p95 = samples[n * 95 / 100];
+  summary.p99 = samples[n * 99 / 100];
+  summary.max = samples[n - 1];
+  return summary;
+}
+
+float ProfHistogram(int bins[kProfBins]) {
+  const float binMs = 2.0f;
+  std::fill(bins, bins + kProfBins, 0);
+  for (int i = 0; i < ProfFrameCount(); i++) {
+    float ms = profiler.frames[i].ms[(int)ProfZone::Frame];
+    int bin = std::min(kProfBins - 1, (int)(ms / binMs));
+    bins[bin]++;
+  }
+  return binMs;
+}
+
+const char *ProfZoneName(ProfZone zone) {
+  return kZoneNames[(int)zone];
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+enum class ProfZone : uint8_t {
+  Input,
+  Actors,
+  Visibility,
+  Enemies,
+  Draw,
+  Ui,
+  Frame,
+  Count
+};
+
+const int kProfFrames = 512;
+const int kProfBins = 24;
+
+struct ProfSummary {
+  float avg;
+  float p50;
+  float p95;
+  float p99;
+  float max;
+};
+
+#ifdef CRYPT_PROFILE
+
+struct ProfScope {
+  ProfZone zone;
+  uint64_t start;
+  explicit ProfScope(ProfZone zone);
+  ~ProfScope();
+};
+
+#define PROF_CONCAT2(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT2(a, b)
+#define PROFILE_ZONE(zone) \
+  ProfScope PROF_CONCAT(profScope, __LINE__)(ProfZone::zone)
+
+void ProfBeginFrame();
+void ProfEndFrame();
+bool ProfOpenCsv(const char *path);
+void ProfCloseCsv();
+int ProfFrameCount();
+ProfSummary ProfSummarize(ProfZone zone);
+float ProfHistogram(int bins[kProfBins]);
+const char *ProfZoneName(ProfZone zone);
+
+#else
+
+#define PROFILE_ZONE(zone) ((void)0)
+
+inline void ProfBeginFrame() {}
+inline void ProfEndFrame() {}
+inline bool ProfOpenCsv(const char *) { return false; }
+inline void ProfCloseCsv() {}
+
+#endif
@@ -1,147 +1,395 @@
 #include "render.h"
 
+#include "profiler.h"
 #include "ui.h"
 
 #include <raylib.h>
 
+#include <algorithm>
 #include <cmath>
 
-static Color Tint(Color c, float f) {
-  return Color{(unsigned char)(c.r * f), (unsigned char)(c.g * f),
-               (unsigned char)(c.b * f), c.a};
-}
-
 static float EaseOut(float t) {
   float inv = 1.0f - t;
   return 1.0f - inv * inv;
 }
 
-static Vector2 ActorPixel(const Game &game, const Actor &actor) {
-  float t = EaseOut(actor.moveT);
+static Vector2 ActorPixel(const Game &game, const Actor &actor, float lead) {
+  float t = EaseOut(std::min(1.0f, actor.moveT + lead));
   float x = (actor.prev.x + (actor.cell.x - actor.prev.x) * t) * game.tileSize;
   float y = (actor.prev.y + (actor.cell.y - actor.prev.y) * t) * game.tileSize;
   return Vector2{x, y};
 }
 
-void DrawGame(const Game &game) {
+static void PushTile(const Game &game, Renderer &renderer, int x, int y,
+                     bool vis, float px, float py) {
+  const Atlas &atlas = renderer.atlas;
+  RenderStats &stats = renderer.stats;
+  TileType tile = GetTile(game.dungeon, x, y);
+  bool even = (x + y) % 2 == 0;
+  TileColor color = even ? TileColor::FloorA : TileColor::FloorB;
+  if (tile == TileType::Wall) {
+    color = even ? TileColor::WallA : TileColor::WallB;
+  } else if (tile == TileType::Door) {
+    color = even ? TileColor::DoorA : TileColor::DoorB;
+  }
+
+  if (tile == TileType::Door && vis) {
+    SpriteId door = even ? SpriteId::DoorA : SpriteId::DoorB;
+    PushSprite(atlas, stats, door, px, py, WHITE);
+  } else {
+    PushSprite(atlas, stats, SpriteId::Solid, px, py,
+               atlas.palette[(int)color][vis ? 1 : 0]);
+  }
+  if (tile == TileType::Wall && vis) {
+    PushSprite(atlas, stats, SpriteId::WallCap, px, py, WHITE);
+  }
+  if (vis && HasTileFlag(game.dungeon, x, y, kTileExit)) {
+    PushSprite(atlas, stats, SpriteId::ExitMark, px, py, WHITE);
+  }
+}
+
+static const int kChunkTiles = 16;
+static const int kMaxChunks = 96;
+static_assert(64 % kChunkTiles == 0, "chunk rows must not straddle words");
+
+static TileRect ChunkRect(const Game &game, int cx, int cy) {
+  int x = cx * kChunkTiles;
+  int y = cy * kChunkTiles;
+  int w = std::min(kChunkTiles, game.dungeon.width - x);
+  int h = std::min(kChunkTiles, game.dungeon.height - y);
+  return TileRect{x, y, w, h};
+}
+
+static void ReleaseChunks(TileCache &cache) {
+  for (auto &chunk : cache.chunks) UnloadRenderTexture(chunk.target);
+  cache.chunks.clear();
+  std::fill(cache.slots.begin(), cache.slots.end(), -1);
+}
+
+static void ResetTileCache(TileCache &cache, const Game &game) {
+  ReleaseChunks(cache);
+  cache.tileSize = game.tileSize;
+  cache.mapRevision = game.mapRevision;
+  cache.chunksX = (game.dungeon.width + kChunkTiles - 1) / kChunkTiles;
+  cache.chunksY = (game.dungeon.height + kChunkTiles - 1) / kChunkTiles;
+  cache.slots.assign(cache.chunksX * cache.chunksY, -1);
+  ResizeBitPlane(cache.bakedSeen, game.dungeon.width, game.dungeon.height);
+  ResizeBitPlane(cache.bakedVisible, game.dungeon.width, game.dungeon.height);
+}
+
+static void CopyBit(BitPlane &dst, const BitPlane &src, int x, int y) {
+  uint64_t mask = 1ULL << (x & 63);
+  uint64_t &word = dst.words[y * dst.stride + (x >> 6)];
+  word = (word & ~mask) | (src.words[y * src.stride + (x >> 6)] & mask);
+}
+
+static void BakeTile(const Game &game, Renderer &renderer, TileRect rect,
+                     int x, int y) {
+  TileCache &cache = renderer.tiles;
+  float px = (float)(x - rect.x) * game.tileSize;
+  float py = (float)(y - rect.y) * game.tileSize;
+  bool seen = TestBit(game.dungeon.seen, x, y);
+  bool vis = TestBit(game.visible, x, y);
+  if (seen) PushTile(game, renderer, x, y, vis, px, py);
+  CopyBit(cache.bakedSeen, game.dungeon.seen, x, y);
+  CopyBit(cache.bakedVisible, game.visible, x, y);
+  renderer.stats.bakedTiles++;
+}
+
+static void EvictChunk(TileCache &cache) {
+  int oldest = -1;
+  for (int i = 0; i < (int)cache.chunks.size(); i++) {
+    if (cache.chunks[i].lastUsed == cache.frame) continue;
+    uint32_t used = cache.chunks[i].lastUsed;
+    if (oldest < 0 || used < cache.chunks[oldest].lastUsed) oldest = i;
+  }
+  if (oldest < 0) return;
+  TileChunk &victim = cache.chunks[oldest];
+  UnloadRenderTexture(victim.target);
+  cache.slots[victim.cy * cache.chunksX + victim.cx] = -1;
+  if (oldest != (int)cache.chunks.size() - 1) {
+    victim = cache.chunks.back();
+    cache.slots[victim.cy * cache.chunksX + victim.cx] = oldest;
+  }
+  cache.chunks.pop_back();
+}
+
+static TileChunk &AcquireChunk(const Game &game, Renderer &renderer, int cx,
+                               int cy) {
+  TileCache &cache = renderer.tiles;
+  int &slot = cache.slots[cy * cache.chunksX + cx];
+  if (slot >= 0) {
+    cache.chunks[slot].lastUsed = cache.frame;
+    return cache.chunks[slot];
+  }
+  if ((int)cache.chunks.size() >= kMaxChunks) EvictChunk(cache);
+
+  TileRect rect = ChunkRect(game, cx, cy);
+  TileChunk chunk;
+  chunk.cx = cx;
+  chunk.cy = cy;
+  chunk.lastUsed = cache.frame;
+  chunk.target = LoadRenderTexture(rect.w * game.tileSize,
+                                   rect.h * game.tileSize);
+  BeginTextureMode(chunk.target);
+  ClearBackground(Color{3, 4, 6, 255});
+  BeginSprites(renderer.atlas, renderer.stats);
+  for (int y = rect.y; y < rect.y + rect.h; y++) {
+    for (int x = rect.x; x < rect.x + rect.w; x++) {
+      BakeTile(game, renderer, rect, x, y);
+    }
+  }
+  EndSprites();
+  EndTextureMode();
+  slot = (int)cache.chunks.size();
+  cache.chunks.push_back(chunk);
+  return cache.chunks.back();
+}
+
+static void RefreshChunk(const Game &game, Renderer &renderer,
+                         const TileChunk &chunk) {
+  TileCache &cache = renderer.tiles;
+  TileRect rect = ChunkRect(game, chunk.cx, chunk.cy);
+  int base = rect.x & ~63;
+  uint64_t mask = ((1ULL << rect.w) - 1) << (rect.x & 63);
+  bool open = false;
+  for (int y = rect.y; y < rect.y + rect.h; y++) {
+    int w = y * cache.bakedSeen.stride + (rect.x >> 6);
+    uint64_t dirty = (game.dungeon.seen.words[w] ^ cache.bakedSeen.words[w]) |
+                     (game.visible.words[w] ^ cache.bakedVisible.words[w]);
+    dirty &= mask;
+    if (dirty && !open) {
+      BeginTextureMode(chunk.target);
+      BeginSprites(renderer.atlas, renderer.stats);
+      open = true;
+    }
+    while (dirty) {
+      BakeTile(game, renderer, rect, base + __builtin_ctzll(dirty), y);
+      dirty &= dirty - 1;
+    }
+  }
+  if (open) {
+    EndSprites();
+    EndTextureMode();
+  }
+}
+
+struct View {
+  Vector2 origin;
+  TileRect tiles;
+  float lead;
+};
+
+static View ComputeView(const Game &game, Vector2 jitter, float lead) {
+  float tile = (float)game.tileSize;
+  float viewW = game.dungeonRect.width;
+  float viewH = game.dungeonRect.height;
+  float maxX = std::max(0.0f, game.dungeon.width * tile - viewW);
+  float maxY = std::max(0.0f, game.dungeon.height * tile - viewH);
+  Vector2 focus = ActorPixel(game, game.player.actor, lead);
+  float camX = std::floor(focus.x + tile * 0.5f - viewW * 0.5f);
+  float camY = std::floor(focus.y + tile * 0.5f - viewH * 0.5f);
+  camX = std::max(0.0f, std::min(camX, maxX));
+  camY = std::max(0.0f, std::min(camY, maxY));
+
+  View view;
+  view.origin = Vector2{game.dungeonRect.x - camX + jitter.x,
+                        game.dungeonRect.y - camY + jitter.y};
+  int x0 = std::max(0, (int)(camX / tile) - 1);
+  int y0 = std::max(0, (int)(camY / tile) - 1);
+  int x1 = std::min(game.dungeon.width, (int)((camX + viewW) / tile) + 2);
+  int y1 = std::min(game.dungeon.height, (int)((camY + viewH) / tile) + 2);
+  view.tiles = TileRect{x0, y0, x1 - x0, y1 - y0};
+  view.lead = lead;
+  return view;
+}
+
+static void UpdateTileCache(const Game &game, Renderer &renderer,
+                            const View &view) {
+  TileCache &cache = renderer.tiles;
+  if (renderer.atlas.tileSize != game.tileSize) {
+    UnloadAtlas(renderer.atlas);
+    BuildAtlas(renderer.atlas, game.tileSize);
+  }
+  if (cache.tileSize != game.tileSize ||
+      cache.mapRevision != game.mapRevision) {
+    ResetTileCache(cache, game);
+  }
+  cache.frame++;
+  int cx0 = view.tiles.x / kChunkTiles;
+  int cy0 = view.tiles.y / kChunkTiles;
+  int cx1 = (view.tiles.x + view.tiles.w - 1) / kChunkTiles;
+  int cy1 = (view.tiles.y + view.tiles.h - 1) / kChunkTiles;
+  for (int cy = cy0; cy <= cy1; cy++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      RefreshChunk(game, renderer, AcquireChunk(game, renderer, cx, cy));
+    }
+  }
+}
+
+static void DrawTileCache(const Game &game, Renderer &renderer,
+                          const View &view) {
+  const TileCache &cache = renderer.tiles;
+  float tile = (float)game.tileSize;
+  for (const auto &chunk : cache.chunks) {
+    if (chunk.lastUsed != cache.frame) continue;
+    TileRect rect = ChunkRect(game, chunk.cx, chunk.cy);
+    Rectangle source{0.0f, 0.0f, (float)chunk.target.texture.width,
+                     -(float)chunk.target.texture.height};
+    Vector2 pos{view.origin.x + rect.x * tile, view.origin.y + rect.y * tile};
+    DrawTextureRec(chunk.target.texture, source, pos, WHITE);
+    renderer.stats.drawCalls++;
+    renderer.stats.chunks++;
+  }
+}
+
+static void DrawActors(const Game &game, Renderer &renderer,
+                       const View &view) {
+  const Atlas &atlas = renderer.atlas;
+  RenderStats &stats = renderer.stats;
+  float tile = (float)game.tileSize;
+  BeginSprites(atlas, stats);
+
+  ForEachSetBit(game.visible, view.tiles, [&](int x, int y) {
+    int slot = game.occupancy.items[TileIndex(game.dungeon, x, y)];
+    if (slot == 0) return;
+    const Item &item = game.items[slot - 1];
+    SpriteId id = item.type == ItemType::Gold ? SpriteId::Gold
+                                              : SpriteId::Potion;
+    PushSprite(atlas, stats, id, view.origin.x + x * tile,
+               view.origin.y + y * tile, WHITE);
+  });
+
+  ForEachSetBit(game.visible, view.tiles, [&](int x, int y) {
+    int slot = game.occupancy.enemies[TileIndex(game.dungeon, x, y)];
+    if (slot == 0) return;
+    int index = slot - 1;
+    Vector2 pos =
+        ActorPixel(game, EnemyActor(game.enemies, index), view.lead);
+    SpriteId id = game.enemies.type[index] == 0 ? SpriteId::Enemy0
+                                                : SpriteId::Enemy1;
+    PushSprite(atlas, stats, id, view.origin.x + pos.x,
+               view.origin.y + pos.y, WHITE);
+  });
+
+  Vector2 pos = ActorPixel(game, game.player.actor, view.lead);
+  PushSprite(atlas, stats, SpriteId::Player, view.origin.x + pos.x,
+             view.origin.y + pos.y, WHITE);
+  EndSprites();
+}
+
+static void DrawLightMap(const Game &game, Renderer &renderer,
+                         const View &view) {
+  if (UpdateLightMap(renderer.light, game, view.tiles)) {
+    renderer.stats.lightUpdates++;
+  }
+  const LightMap &light = renderer.light;
+  if (!light.loaded) return;
+  float tile = (float)game.tileSize;
+  Rectangle source{0.0f, 0.0f, (float)light.area.w, (float)light.area.h};
+  Rectangle dest{view.origin.x + light.area.x * tile,
+                 view.origin.y + light.area.y * tile, light.area.w * tile,
+                 light.area.h * tile};
+  BeginBlendMode(BLEND_MULTIPLIED);
+  DrawTexturePro(light.texture, source, dest, Vector2{0.0f, 0.0f}, 0.0f,
+                 WHITE);
+  EndBlendMode();
+  renderer.stats.drawCalls++;
+}
+
+static void DrawRenderStats(const Game &game, const Renderer &renderer) {
+  const RenderStats &stats = renderer.stats;
+  DrawRectangle(8, 8, 200, 140, Color{0, 0, 0, 170});
+  Color c{200, 220, 200, 255};
+  DrawText(TextFormat("draw calls %i", stats.drawCalls), 16, 14, 16, c);
+  DrawText(TextFormat("quads %i", stats.quads), 16, 30, 16, c);
+  DrawText(TextFormat("vertices %i", stats.quads * 4), 16, 46, 16, c);
+  DrawText(TextFormat("baked tiles %i", stats.bakedTiles), 16, 62, 16, c);
+  DrawText(TextFormat("chunks %i", stats.chunks), 16, 78, 16, c);
+  DrawText(TextFormat("hud bakes %i", stats.hudBakes), 16, 94, 16, c);
+  DrawText(TextFormat("light updates %i", stats.lightUpdates), 16, 110, 16,
+           c);
+  DrawText(TextFormat("explored %i%%", game.exploredPct), 16, 126, 16, c);
+}
+
+#ifdef CRYPT_PROFILE
+static void DrawProfiler(const Game &game) {
+  const int w = 300;
+  const int h = 228;
+  int x = game.screenWidth - w - 8;
+  int y = 8;
+  DrawRectangle(x, y, w, h, Color{0, 0, 0, 190});
+  Color text{200, 220, 200, 255};
+  DrawText(TextFormat("%-10s  avg   p50   p95   p99", "zone ms"), x + 8,
+           y + 6, 10, text);
+  for (int i = 0; i < (int)ProfZone::Count; i++) {
+    ProfZone zone = (ProfZone)i;
+    ProfSummary s = ProfSummarize(zone);
+    DrawText(TextFormat("%-10s %5.2f %5.2f %5.2f %5.2f", ProfZoneName(zone),
+                        s.avg, s.p50, s.p95, s.p99),
+             x + 8, y + 22 + i * 14, 10, text);
+  }
+
+  int bins[kProfBins];
+  float binMs = ProfHistogram(bins);
+  int peak = *std::max_element(bins, bins + kProfBins);
+  int barW = (w - 16) / kProfBins;
+  int baseY = y + h - 22;
+  for (int i = 0; i < kProfBins; i++) {
+    int barH = peak > 0 ? bins[i] * 90 / peak : 0;
+    Color c = i * binMs < 16.7f ? Color{90, 180, 110, 255}
+                                : Color{200, 90, 80, 255};
+    DrawRectangle(x + 8 + i * barW, baseY - barH, barW - 1, barH, c);
+  }
+  DrawText(TextFormat("frame time, %.0f ms bins, %i frames", binMs,
+                      ProfFrameCount()),
+           x + 8, baseY + 6, 10, text);
+}
+#endif
+
+void InitRenderer(Renderer &renderer) {
+  renderer.tiles = TileCache{};
+  renderer.tiles.tileSize = -1;
+  renderer.tiles.mapRevision = -1;
+  renderer.atlas = Atlas{};
+  renderer.atlas.tileSize = -1;
+  InitHud(renderer.hud);
+  InitLightMap(renderer.light);
+  renderer.stats = RenderStats{};
+  renderer.showStats = false;
+  renderer.showProfiler = false;
+}
+
+void UnloadRenderer(Renderer &renderer) {
+  ReleaseChunks(renderer.tiles);
+  UnloadAtlas(renderer.atlas);
+  UnloadHud(renderer.hud);
+  UnloadLightMap(renderer.light);
+}
+
+void DrawGame(const Game &game, Renderer &renderer, float sinceTick) {
+  PROFILE_ZONE(Draw);
+  renderer.stats = RenderStats{};
   Color bgTop{16, 22, 32, 255};
   Color bgBottom{6, 10, 18, 255};
   DrawRectangleGradientV(0, 0, game.screenWidth, game.screenHeight, bgTop,
                          bgBottom);
 
-  Vector2 jitter{0.0f, 0.0f};
-  if (game.shake > 0.0f) {
-    jitter.x = (float)GetRandomValue(-2, 2);
-    jitter.y = (float)GetRandomValue(-2, 2);
-  }
+  Vector2 jitter{(float)game.shakeX, (float)game.shakeY};
+  View view = ComputeView(game, jitter, sinceTick / game.animTime);
+
+  UpdateTileCache(game, renderer, view);
 
   BeginScissorMode((int)game.dungeonRect.x, (int)game.dungeonRect.y,
                    (int)game.dungeonRect.width, (int)game.dungeonRect.height);
 
-  Color floorA{44, 46, 54, 255};
-  Color floorB{50, 52, 60, 255};
-  Color wallA{20, 22, 28, 255};
-  Color wallB{32, 34, 40, 255};
-  Color unseen{3, 4, 6, 255};
-  Color exitColor{90, 120, 160, 255};
-  Color doorA{118, 84, 44, 255};
-  Color doorB{134, 96, 52, 255};
-  Color doorLine{60, 40, 18, 220};
-
-  for (int y = 0; y < game.dungeon.height; y++) {
-    for (int x = 0; x < game.dungeon.width; x++) {
-      int idx = TileIndex(game.dungeon, x, y);
-      bool seen = game.dungeon.seen[idx] != 0;
-      bool vis = game.visible[idx] != 0;
-      float px = game.dungeonRect.x + jitter.x + x * game.tileSize;
-      float py = game.dungeonRect.y + jitter.y + y * game.tileSize;
-
-      if (!seen) {
-        DrawRectangle((int)px, (int)py, game.tileSize, game.tileSize, unseen);
-        continue;
-      }
-
-      TileType tile = GetTile(game.dungeon, x, y);
-      Color base = ((x + y) % 2 == 0) ? floorA : floorB;
-      if (tile == TileType::Wall) {
-        base = ((x + y) % 2 == 0) ? wallA : wallB;
-      } else if (tile == TileType::Door) {
-        base = ((x + y) % 2 == 0) ? doorA : doorB;
-      }
-
-      if (!vis) base = Tint(base, 0.45f);
-      DrawRectangle((int)px, (int)py, game.tileSize, game.tileSize, base);
-
-      if (tile == TileType::Wall && vis) {
-        DrawRectangle((int)px, (int)py, game.tileSize, 4,
-                      Tint(Color{120, 120, 140, 255}, 0.3f));
-      }
-
-      if (tile == TileType::Door && vis) {
-        DrawRectangle((int)px + 6, (int)py + 6, game.tileSize - 12,
-                      game.tileSize - 12, Tint(base, 1.1f));
-        DrawRectangleLines((int)px + 6, (int)py + 6, game.tileSize - 12,
-                           game.tileSize - 12, doorLine);
-        DrawCircle((int)(px + game.tileSize * 0.65f),
-                   (int)(py + game.tileSize * 0.5f), 2.0f,
-                   Color{220, 190, 100, 255});
-      }
-
-      if (vis && game.dungeon.exit.x == x && game.dungeon.exit.y == y) {
-        DrawRectangle((int)px + 6, (int)py + 6, game.tileSize - 12,
-                      game.tileSize - 12, exitColor);
-      }
-    }
-  }
+  DrawTileCache(game, renderer, view);
 
-  Vector2 lightCenter = ActorPixel(game, game.player.actor);
-  lightCenter.x += game.tileSize * 0.5f + jitter.x;
-  lightCenter.y += game.tileSize * 0.5f + jitter.y;
-  DrawCircleGradient((int)lightCenter.x, (int)lightCenter.y, 140.0f,
-                     Color{80, 110, 140, 50}, Color{0, 0, 0, 0});
-
-  for (const auto &item : game.items) {
-    int idx = TileIndex(game.dungeon, item.cell.x, item.cell.y);
-    if (item.picked || game.visible[idx] == 0) continue;
-    Vector2 pos = ActorPixel(game, Actor{item.cell, item.cell, 1.0f});
-    pos.x += jitter.x;
-    pos.y += jitter.y;
-    Color c = item.type == ItemType::Gold ? Color{220, 190, 90, 255}
-                                          : Color{170, 80, 140, 255};
-    DrawCircle((int)(pos.x + game.tileSize * 0.5f),
-               (int)(pos.y + game.tileSize * 0.5f), 6.0f, c);
-    DrawCircleLines((int)(pos.x + game.tileSize * 0.5f),
-                    (int)(pos.y + game.tileSize * 0.5f), 6.0f,
-                    Color{30, 20, 10, 200});
-  }
-
-  for (const auto &enemy : game.enemies) {
-    if (enemy.hp <= 0) continue;
-    int idx = TileIndex(game.dungeon, enemy.actor.cell.x, enemy.actor.cell.y);
-    if (game.visible[idx] == 0) continue;
-    Vector2 pos = ActorPixel(game, enemy.actor);
-    pos.x += jitter.x;
-    pos.y += jitter.y;
-    Color c = enemy.type == 0 ? Color{100, 180, 100, 255}
-                               : Color{210, 200, 180, 255};
-    DrawRectangle((int)(pos.x + 6), (int)(pos.y + 8), game.tileSize - 12,
-                  game.tileSize - 12, c);
-    DrawRectangleLines((int)(pos.x + 6), (int)(pos.y + 8), game.tileSize - 12,
-                       game.tileSize - 12, Color{30, 20, 20, 180});
-  }
-
-  Vector2 playerPos = ActorPixel(game, game.player.actor);
-  playerPos.x += jitter.x;
-  playerPos.y += jitter.y;
-  DrawCircle((int)(playerPos.x + game.tileSize * 0.5f),
-             (int)(playerPos.y + game.tileSize * 0.5f), 10.0f,
-             Color{220, 230, 245, 255});
-  DrawCircleLines((int)(playerPos.x + game.tileSize * 0.5f),
-                  (int)(playerPos.y + game.tileSize * 0.5f), 10.0f,
-                  Color{40, 50, 70, 220});
+  DrawActors(game, renderer, view);
+  DrawLightMap(game, renderer, view);
 
   EndScissorMode();
-  DrawUI(game);
+  DrawUI(game, renderer.hud, renderer.stats);
 
   if (game.mode == GameMode::Title || game.mode == GameMode::GameOver) {
     DrawRectangle(0, 0, game.screenWidth, game.screenHeight,
@@ -159,4 +407,9 @@ void DrawGame(const Game &game) {
     DrawText("Press R or Start to retry", 410, 300, 20,
              Color{200, 200, 210, 255});
   }
+
+  if (renderer.showStats) DrawRenderStats(game, renderer);
+#ifdef CRYPT_PROFILE
+  if (renderer.showProfiler) DrawProfiler(game);
+#endif
 }
@@ -1,5 +1,45 @@
 #pragma once
 
+#include "bitplane.h"
 #include "game.h"
+#include "lightmap.h"
+#include "sprites.h"
+#include "ui.h"
 
-void DrawGame(const Game &game);
+#include <raylib.h>
+
+#include <cstdint>
+#include <vector>
+
+struct TileChunk {
+  int cx;
+  int cy;
+  RenderTexture2D target;
+  uint32_t lastUsed;
+};
+
+struct TileCache {
+  int tileSize;
+  int mapRevision;
+  int chunksX;
+  int chunksY;
+  uint32_t frame;
+  std::vector<int> slots;
+  std::vector<TileChunk> chunks;
+  BitPlane bakedSeen;
+  BitPlane bakedVisible;
+};
+
+struct Renderer {
+  TileCache tiles;
+  Atlas atlas;
+  HudCache hud;
+  LightMap light;
+  RenderStats stats;
+  bool showStats;
+  bool showProfiler;
+};
+
+void InitRenderer(Renderer &renderer);
+void UnloadRenderer(Renderer &renderer);
+void DrawGame(const Game &game, Renderer &renderer, float sinceTick);
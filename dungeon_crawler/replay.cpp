@@ -0,0 +1,153 @@
+#include "replay.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const char kReplayMagic[4] = {'C', 'R', 'P', 'L'};
+static const uint32_t kReplayVersion = 4;
+
+static uint16_t PackAction(const InputAction &action) {
+  uint16_t bits = (uint16_t)((action.dx + 1) | ((action.dy + 1) << 2));
+  if (action.wait) bits |= 1 << 4;
+  if (action.usePotion) bits |= 1 << 5;
+  if (action.restart) bits |= 1 << 6;
+  if (action.confirm) bits |= 1 << 7;
+  if (action.skipAnim) bits |= 1 << 8;
+  return bits;
+}
+
+static InputAction UnpackAction(uint16_t bits) {
+  InputAction action;
+  action.dx = (bits & 3) - 1;
+  action.dy = ((bits >> 2) & 3) - 1;
+  action.wait = bits & (1 << 4);
+  action.usePotion = bits & (1 << 5);
+  action.restart = bits & (1 << 6);
+  action.confirm = bits & (1 << 7);
+  action.skipAnim = bits & (1 << 8);
+  return action;
+}
+
+void BeginReplay(Replay &replay, const GameConfig &config) {
+  replay.config = config;
+  replay.frames = 0;
+  replay.runs.clear();
+}
+
+void RecordFrame(Replay &replay, const InputAction &action, float dt) {
+  uint16_t bits = PackAction(action);
+  uint32_t dtBits;
+  std::memcpy(&dtBits, &dt, sizeof(dtBits));
+  replay.frames++;
+  if (!replay.runs.empty()) {
+    ReplayRun &last = replay.runs.back();
+    if (last.action == bits && last.dtBits == dtBits &&
+        last.count < UINT32_MAX) {
+      last.count++;
+      return;
+    }
+  }
+  replay.runs.push_back(ReplayRun{bits, dtBits, 1});
+}
+
+bool NextReplayFrame(const Replay &replay, ReplayCursor &cursor,
+                     InputAction &action, float &dt) {
+  if (cursor.run >= replay.runs.size()) return false;
+  const ReplayRun &run = replay.runs[cursor.run];
+  action = UnpackAction(run.action);
+  std::memcpy(&dt, &run.dtBits, sizeof(dt));
+  if (++cursor.used >= run.count) {
+    cursor.run++;
+    cursor.used = 0;
+  }
+  return true;
+}
+
+template <typename T>
+static bool Write(FILE *file, const T &value) {
+  return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool Read(FILE *file, T &value) {
+  return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+static bool WriteRules(FILE *file, const GameConfig &config) {
+  for (int type = 0; type < kEnemyTypes; type++) {
+    if (!Write(file, (int32_t)config.enemyDamage[type]) ||
+        !Write(file, (int32_t)config.enemySpeed[type])) {
+      return false;
+    }
+  }
+  return Write(file, (uint8_t)config.sleepingEnemies);
+}
+
+static bool ReadRules(FILE *file, GameConfig &config) {
+  for (int type = 0; type < kEnemyTypes; type++) {
+    int32_t damage = 0;
+    int32_t speed = 0;
+    if (!Read(file, damage) || !Read(file, speed) || damage < 0 ||
+        speed <= 0 || speed > kMaxSpeed) {
+      return false;
+    }
+    config.enemyDamage[type] = damage;
+    config.enemySpeed[type] = speed;
+  }
+  uint8_t sleeping = 0;
+  if (!Read(file, sleeping)) return false;
+  config.sleepingEnemies = sleeping != 0;
+  return true;
+}
+
+bool SaveReplay(const Replay &replay, const char *path) {
+  FILE *file = std::fopen(path, "wb");
+  if (!file) return false;
+  bool ok = std::fwrite(kReplayMagic, 4, 1, file) == 1 &&
+            Write(file, kReplayVersion) && Write(file, replay.config.seed) &&
+            Write(file, (int32_t)replay.config.mapWidth) &&
+            Write(file, (int32_t)replay.config.mapHeight) &&
+            Write(file, (int32_t)replay.config.generator) &&
+            WriteRules(file, replay.config) &&
+            Write(file, replay.frames) &&
+            Write(file, (uint32_t)replay.runs.size());
+  for (size_t i = 0; ok && i < replay.runs.size(); i++) {
+    const ReplayRun &run = replay.runs[i];
+    ok = Write(file, run.action) && Write(file, run.dtBits) &&
+         Write(file, run.count);
+  }
+  return std::fclose(file) == 0 && ok;
+}
+
+bool LoadReplay(Replay &replay, const char *path) {
+  FILE *file = std::fopen(path, "rb");
+  if (!file) return false;
+  char magic[4];
+  uint32_t version = 0;
+  int32_t width = 0;
+  int32_t height = 0;
+  int32_t generator = 0;
+  uint32_t runs = 0;
+  replay.config = DefaultGameConfig(0);
+  bool ok = std::fread(magic, 4, 1, file) == 1 &&
+            std::memcmp(magic, kReplayMagic, 4) == 0 &&
+            Read(file, version) && version == kReplayVersion &&
+            Read(file, replay.config.seed) && Read(file, width) &&
+            Read(file, height) && Read(file, generator) &&
+            generator >= 0 &&
+            generator <= (int32_t)GenerateMode::Partitioned &&
+            ReadRules(file, replay.config) &&
+            Read(file, replay.frames) && Read(file, runs);
+  replay.config.mapWidth = width;
+  replay.config.mapHeight = height;
+  replay.config.generator = (GenerateMode)generator;
+  replay.runs.clear();
+  for (uint32_t i = 0; ok && i < runs; i++) {
+    ReplayRun run;
+    ok = Read(file, run.action) && Read(file, run.dtBits) &&
+         Read(file, run.count) && run.count > 0;
+    if (ok) replay.runs.push_back(run);
+  }
+  std::fclose(file);
+  return ok;
+}
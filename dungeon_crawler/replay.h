@@ -0,0 +1,32 @@
+#pragma once
+
+#include "game.h"
+#include "input.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ReplayRun {
+  uint16_t action;
+  uint32_t dtBits;
+  uint32_t count;
+};
+
+struct Replay {
+  GameConfig config;
+  uint64_t frames;
+  std::vector<ReplayRun> runs;
+};
+
+struct ReplayCursor {
+  size_t run;
+  uint32_t used;
+};
+
+void BeginReplay(Replay &replay, const GameConfig &config);
+void RecordFrame(Replay &replay, const InputAction &action, float dt);
+bool NextReplayFrame(const Replay &replay, ReplayCursor &cursor,
+                     InputAction &action, float &dt);
+bool SaveReplay(const Replay &replay, const char *path);
+bool LoadReplay(Replay &replay, const char *path);
@@ -0,0 +1,56 @@
+#include "rng.h"
+
+#include <cstdlib>
+
+static uint64_t SplitMix64(uint64_t &seed) {
+  uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static uint32_t RotateLeft(uint32_t x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+static Rng SeedRng(uint64_t seed) {
+  Rng rng;
+  rng.state[0] = (uint32_t)(SplitMix64(seed) & 0xffffffff);
+  rng.state[1] = (uint32_t)((SplitMix64(seed) & 0xffffffff00000000ULL) >> 32);
+  rng.state[2] = (uint32_t)(SplitMix64(seed) & 0xffffffff);
+  rng.state[3] = (uint32_t)((SplitMix64(seed) & 0xffffffff00000000ULL) >> 32);
+  return rng;
+}
+
+Rng MakeRng(uint64_t seed, RngStream stream) {
+  uint64_t key = (uint64_t)stream * 0xd1342543de82ef95ULL;
+  return SeedRng(seed ^ key);
+}
+
+Rng SplitRng(Rng &rng) {
+  uint64_t hi = NextRandom(rng);
+  uint64_t lo = NextRandom(rng);
+  return SeedRng((hi << 32) | lo);
+}
+
+uint32_t NextRandom(Rng &rng) {
+  uint32_t *s = rng.state;
+  uint32_t result = RotateLeft(s[1] * 5, 7) * 9;
+  uint32_t t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = RotateLeft(s[3], 11);
+  return result;
+}
+
+int RandomValue(Rng &rng, int min, int max) {
+  if (min > max) {
+    int tmp = max;
+    max = min;
+    min = tmp;
+  }
+  return (int)(NextRandom(rng) % (std::abs(max - min) + 1)) + min;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+struct Rng {
+  uint32_t state[4];
+};
+
+enum class RngStream : uint64_t {
+  Floor,
+  Combat,
+  Cosmetic,
+  Generate,
+  Populate
+};
+
+Rng MakeRng(uint64_t seed, RngStream stream);
+Rng SplitRng(Rng &rng);
+uint32_t NextRandom(Rng &rng);
+int RandomValue(Rng &rng, int min, int max);
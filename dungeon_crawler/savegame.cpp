@@ -0,0 +1,312 @@
+#include "savegame.h"
+
+#include "game_internal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+static const char kSaveMagic[4] = {'C', 'R', 'S', 'V'};
+static const uint32_t kSaveVersion = 6;
+
+struct SaveHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t layout;
+  int32_t mode;
+  uint64_t seed;
+  int32_t width;
+  int32_t height;
+  int32_t generator;
+  int32_t enemyDamage[kEnemyTypes];
+  int32_t enemySpeed[kEnemyTypes];
+  int32_t sleepingEnemies;
+  int32_t turn;
+  int32_t floor;
+  int32_t nextFloorSeed;
+  int32_t exploredTiles;
+  int32_t seenWords;
+  GridPos exit;
+  Player player;
+  Rng floorRng;
+  Rng combatRng;
+  Rng cosmeticRng;
+  uint32_t roomCount;
+  uint32_t enemyCount;
+  uint32_t itemCount;
+  uint32_t logCount;
+  double logClock;
+  int64_t schedulerNow;
+  uint32_t schedulerSeq;
+};
+
+static_assert(sizeof(TileType) == 1, "TileType must be one byte");
+static_assert(std::is_trivially_copyable<Room>::value, "Room must be POD");
+static_assert(std::is_trivially_copyable<Item>::value, "Item must be POD");
+static_assert(std::is_trivially_copyable<LogEntry>::value,
+              "LogEntry must be POD");
+
+static uint32_t LayoutTag() {
+  return (uint32_t)(sizeof(SaveHeader) ^ sizeof(Room) << 8 ^
+                    sizeof(GridPos) << 16 ^ sizeof(Item) << 24 ^
+                    sizeof(LogEntry) << 4);
+}
+
+static size_t Align8(size_t size) {
+  return (size + 7) & ~(size_t)7;
+}
+
+static void Append(std::vector<uint8_t> &buffer, const void *data,
+                   size_t size) {
+  size_t at = buffer.size();
+  buffer.resize(at + Align8(size));
+  if (size > 0) std::memcpy(buffer.data() + at, data, size);
+}
+
+bool SaveGame(const Game &game, const char *path) {
+  const Dungeon &dungeon = game.dungeon;
+  SaveHeader header = {};
+  std::memcpy(header.magic, kSaveMagic, 4);
+  header.version = kSaveVersion;
+  header.layout = LayoutTag();
+  header.mode = (int32_t)game.mode;
+  header.seed = game.config.seed;
+  header.width = dungeon.width;
+  header.height = dungeon.height;
+  header.generator = (int32_t)game.config.generator;
+  for (int type = 0; type < kEnemyTypes; type++) {
+    header.enemyDamage[type] = game.config.enemyDamage[type];
+    header.enemySpeed[type] = game.config.enemySpeed[type];
+  }
+  header.sleepingEnemies = game.config.sleepingEnemies;
+  header.turn = game.turn;
+  header.floor = game.floor;
+  header.nextFloorSeed = game.nextFloorSeed;
+  header.exploredTiles = game.exploredTiles;
+  header.seenWords = (int32_t)dungeon.seen.words.size();
+  header.exit = dungeon.exit;
+  header.player = game.player;
+  header.floorRng = game.floorRng;
+  header.combatRng = game.combatRng;
+  header.cosmeticRng = game.cosmeticRng;
+  header.roomCount = (uint32_t)dungeon.rooms.size();
+  header.enemyCount = (uint32_t)EnemyCount(game.enemies);
+  header.itemCount = (uint32_t)game.items.size();
+  header.logCount = game.log.count;
+  header.logClock = game.log.clock;
+  header.schedulerNow = game.scheduler.now;
+  header.schedulerSeq = game.scheduler.seq;
+
+  std::vector<uint8_t> buffer;
+  buffer.reserve(sizeof(header) + dungeon.tiles.size() +
+                 dungeon.seen.words.size() * 8 +
+                 header.enemyCount * 48 +
+                 game.items.size() * sizeof(Item) + sizeof(game.log.entries) +
+                 64);
+  Append(buffer, &header, sizeof(header));
+  Append(buffer, dungeon.tiles.data(), dungeon.tiles.size());
+  Append(buffer, dungeon.seen.words.data(), dungeon.seen.words.size() * 8);
+  Append(buffer, dungeon.rooms.data(), dungeon.rooms.size() * sizeof(Room));
+  const EnemyPool &pool = game.enemies;
+  Append(buffer, pool.cell.data(), pool.cell.size() * sizeof(GridPos));
+  Append(buffer, pool.prev.data(), pool.prev.size() * sizeof(GridPos));
+  Append(buffer, pool.moveT.data(), pool.moveT.size() * sizeof(float));
+  Append(buffer, pool.hp.data(), pool.hp.size() * sizeof(int32_t));
+  Append(buffer, pool.type.data(), pool.type.size());
+  Append(buffer, pool.speed.data(), pool.speed.size() * sizeof(int16_t));
+  Append(buffer, pool.awake.data(), pool.awake.size());
+  Append(buffer, pool.nextTurn.data(), pool.nextTurn.size() * sizeof(int64_t));
+  Append(buffer, pool.turnSeq.data(), pool.turnSeq.size() * sizeof(uint32_t));
+  Append(buffer, game.items.data(), game.items.size() * sizeof(Item));
+  Append(buffer, game.log.entries, sizeof(game.log.entries));
+
+  FILE *file = std::fopen(path, "wb");
+  if (!file) return false;
+  bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file) ==
+            buffer.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+struct SaveReader {
+  const uint8_t *data;
+  size_t size;
+  size_t at;
+};
+
+static const uint8_t *Take(SaveReader &reader, size_t size) {
+  size_t padded = Align8(size);
+  if (padded > reader.size - reader.at) return nullptr;
+  const uint8_t *ptr = reader.data + reader.at;
+  reader.at += padded;
+  return ptr;
+}
+
+template <typename T>
+static bool TakeArray(SaveReader &reader, std::vector<T> &out, size_t count) {
+  if (count > reader.size / sizeof(T)) return false;
+  const uint8_t *ptr = Take(reader, count * sizeof(T));
+  if (!ptr) return false;
+  out.resize(count);
+  if (count > 0) std::memcpy(out.data(), ptr, count * sizeof(T));
+  return true;
+}
+
+static bool ValidCell(const SaveHeader &header, GridPos cell) {
+  return cell.x >= 0 && cell.y >= 0 && cell.x < header.width &&
+         cell.y < header.height;
+}
+
+static bool ReadSave(Game &game, SaveReader &reader) {
+  const uint8_t *raw = Take(reader, sizeof(SaveHeader));
+  if (!raw) return false;
+  SaveHeader header;
+  std::memcpy(&header, raw, sizeof(header));
+  if (std::memcmp(header.magic, kSaveMagic, 4) != 0 ||
+      header.version != kSaveVersion || header.layout != LayoutTag()) {
+    return false;
+  }
+  if (header.width < 16 || header.height < 16 || header.width > 2048 ||
+      header.height > 2048 || header.roomCount == 0 || header.mode < 0 ||
+      header.mode > (int32_t)GameMode::GameOver || header.generator < 0 ||
+      header.generator > (int32_t)GenerateMode::Partitioned) {
+    return false;
+  }
+  for (int type = 0; type < kEnemyTypes; type++) {
+    if (header.enemyDamage[type] < 0 || header.enemySpeed[type] <= 0 ||
+        header.enemySpeed[type] > kMaxSpeed) {
+      return false;
+    }
+  }
+
+  Dungeon dungeon;
+  ResizeTiles(dungeon, header.width, header.height);
+  dungeon.exit = header.exit;
+  ResizeBitPlane(dungeon.seen, dungeon.width, dungeon.height);
+  if (header.seenWords != (int32_t)dungeon.seen.words.size()) return false;
+
+  EnemyPool pool;
+  uint32_t enemies = header.enemyCount;
+  std::vector<Item> items;
+  std::vector<LogEntry> log;
+  if (!TakeArray(reader, dungeon.tiles, dungeon.tiles.size()) ||
+      !TakeArray(reader, dungeon.seen.words, header.seenWords) ||
+      !TakeArray(reader, dungeon.rooms, header.roomCount) ||
+      !TakeArray(reader, pool.cell, enemies) ||
+      !TakeArray(reader, pool.prev, enemies) ||
+      !TakeArray(reader, pool.moveT, enemies) ||
+      !TakeArray(reader, pool.hp, enemies) ||
+      !TakeArray(reader, pool.type, enemies) ||
+      !TakeArray(reader, pool.speed, enemies) ||
+      !TakeArray(reader, pool.awake, enemies) ||
+      !TakeArray(reader, pool.nextTurn, enemies) ||
+      !TakeArray(reader, pool.turnSeq, enemies) ||
+      !TakeArray(reader, items, header.itemCount) ||
+      !TakeArray(reader, log, kLogCapacity)) {
+    return false;
+  }
+
+  for (TileType tile : dungeon.tiles) {
+    if ((uint8_t)tile > (uint8_t)TileType::Door) return false;
+  }
+  for (int y = -1; y <= dungeon.height; y++) {
+    for (int x = -1; x <= dungeon.width; x++) {
+      bool border = !InBounds(dungeon, x, y);
+      if (border && GetTile(dungeon, x, y) != TileType::Wall) return false;
+    }
+  }
+  if (header.schedulerNow < 0) return false;
+  for (uint32_t i = 0; i < enemies; i++) {
+    if (!ValidCell(header, pool.cell[i]) || pool.type[i] >= kEnemyTypes ||
+        pool.hp[i] <= 0 || pool.speed[i] <= 0 || pool.speed[i] > kMaxSpeed) {
+      return false;
+    }
+    int64_t due = pool.nextTurn[i] - header.schedulerNow;
+    if (pool.awake[i] &&
+        (due < -kActionCost || due > ActionDelay(pool.speed[i]))) {
+      return false;
+    }
+  }
+  for (const auto &item : items) {
+    if (!ValidCell(header, item.cell) ||
+        (item.type != ItemType::Potion && item.type != ItemType::Gold)) {
+      return false;
+    }
+  }
+  if (!ValidCell(header, header.exit) ||
+      !ValidCell(header, header.player.actor.cell)) {
+    return false;
+  }
+  int logSize = header.logCount < (uint32_t)kLogCapacity ? header.logCount
+                                                         : kLogCapacity;
+  for (int i = 0; i < logSize; i++) {
+    if (log[i].msg >= LogMsg::Count) return false;
+  }
+  BuildTileFlags(dungeon);
+
+  game.config.seed = header.seed;
+  game.config.mapWidth = header.width;
+  game.config.mapHeight = header.height;
+  game.config.generator = (GenerateMode)header.generator;
+  for (int type = 0; type < kEnemyTypes; type++) {
+    game.config.enemyDamage[type] = header.enemyDamage[type];
+    game.config.enemySpeed[type] = header.enemySpeed[type];
+  }
+  game.config.sleepingEnemies = header.sleepingEnemies != 0;
+  game.mode = (GameMode)header.mode;
+  game.turn = header.turn;
+  game.floor = header.floor;
+  game.nextFloorSeed = header.nextFloorSeed;
+  game.player = header.player;
+  game.floorRng = header.floorRng;
+  game.combatRng = header.combatRng;
+  game.cosmeticRng = header.cosmeticRng;
+  game.dungeon = std::move(dungeon);
+  EnemyPool &live = game.enemies;
+  ClearEnemies(live);
+  for (uint32_t i = 0; i < enemies; i++) {
+    int index = SpawnEnemy(live, pool.cell[i], pool.type[i], pool.hp[i],
+                           pool.speed[i]);
+    live.prev[index] = pool.prev[i];
+    live.moveT[index] = pool.moveT[i];
+    live.awake[index] = pool.awake[i];
+    live.nextTurn[index] = pool.nextTurn[i];
+    live.turnSeq[index] = pool.turnSeq[i];
+  }
+  game.scheduler.now = header.schedulerNow;
+  game.scheduler.seq = header.schedulerSeq;
+  game.items = std::move(items);
+  std::memcpy(game.log.entries, log.data(), sizeof(game.log.entries));
+  game.log.count = header.logCount;
+  game.log.clock = header.logClock;
+  game.exploredTiles = header.exploredTiles;
+  game.shake = 0.0f;
+  game.lastHitBy = -1;
+  RestoreFloor(game);
+  ResizeGame(game, game.screenWidth, game.screenHeight);
+  StartNextFloor(game);
+  return true;
+}
+
+bool LoadGame(Game &game, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SaveHeader)) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd,
+                   0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+  SaveReader reader{(const uint8_t *)map, (size_t)info.st_size, 0};
+  bool ok = ReadSave(game, reader);
+  munmap(map, (size_t)info.st_size);
+  return ok;
+}
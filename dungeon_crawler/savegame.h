@@ -0,0 +1,6 @@
+#pragma once
+
+#include "game.h"
+
+bool SaveGame(const Game &game, const char *path);
+bool LoadGame(Game &game, const char *path);
@@ -0,0 +1,51 @@
+#include "scheduler.h"
+
+#include <algorithm>
+
+static bool Later(const TurnEntry &a, const TurnEntry &b) {
+  if (a.time != b.time) return a.time > b.time;
+  return a.seq > b.seq;
+}
+
+static void Push(TurnScheduler &scheduler, const TurnEntry &entry) {
+  scheduler.heap.push_back(entry);
+  std::push_heap(scheduler.heap.begin(), scheduler.heap.end(), Later);
+}
+
+void ResetScheduler(TurnScheduler &scheduler) {
+  scheduler.now = 0;
+  scheduler.seq = 0;
+  scheduler.heap.clear();
+}
+
+void ScheduleEnemy(TurnScheduler &scheduler, EnemyPool &pool, int index,
+                   int64_t time) {
+  uint32_t seq = scheduler.seq++;
+  pool.nextTurn[index] = time;
+  pool.turnSeq[index] = seq;
+  Push(scheduler, TurnEntry{time, seq, GetEnemyHandle(pool, index)});
+}
+
+void RestoreSchedule(TurnScheduler &scheduler, const EnemyPool &pool) {
+  scheduler.heap.clear();
+  for (int i = 0; i < EnemyCount(pool); i++) {
+    if (!pool.awake[i]) continue;
+    scheduler.heap.push_back(
+        TurnEntry{pool.nextTurn[i], pool.turnSeq[i], GetEnemyHandle(pool, i)});
+  }
+  std::make_heap(scheduler.heap.begin(), scheduler.heap.end(), Later);
+}
+
+bool PopDueEnemy(TurnScheduler &scheduler, const EnemyPool &pool, int &index) {
+  while (!scheduler.heap.empty() &&
+         scheduler.heap.front().time < scheduler.now) {
+    std::pop_heap(scheduler.heap.begin(), scheduler.heap.end(), Later);
+    TurnEntry entry = scheduler.heap.back();
+    scheduler.heap.pop_back();
+    int found = FindEnemy(pool, entry.handle);
+    if (found < 0 || pool.turnSeq[found] != entry.seq) continue;
+    index = found;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "enemy_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+struct TurnEntry {
+  int64_t time;
+  uint32_t seq;
+  EnemyHandle handle;
+};
+
+struct TurnScheduler {
+  int64_t now;
+  uint32_t seq;
+  std::vector<TurnEntry> heap;
+};
+
+const int kActionCost = 100;
+const int kMaxSpeed = 1000;
+
+void ResetScheduler(TurnScheduler &scheduler);
+void ScheduleEnemy(TurnScheduler &scheduler, EnemyPool &pool, int index,
+                   int64_t time);
+void RestoreSchedule(TurnScheduler &scheduler, const EnemyPool &pool);
+bool PopDueEnemy(TurnScheduler &scheduler, const EnemyPool &pool, int &index);
+
+inline int ActionDelay(int speed) {
+  int delay = kActionCost * 100 / (speed > 0 ? speed : 1);
+  return delay > 0 ? delay : 1;
+}
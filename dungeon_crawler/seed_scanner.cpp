@@ -0,0 +1,309 @@
+#include "dungeon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ScanConfig {
+  int width;
+  int height;
+  long long firstSeed;
+  long long count;
+  int threads;
+  int minRooms;
+  int maxRooms;
+  int minExit;
+  int maxExit;
+  int maxCorridor;
+  int printLimit;
+  GenerateMode mode;
+  bool compare;
+};
+
+struct FloorStats {
+  int seed;
+  int rooms;
+  int corridor;
+  int exitDistance;
+};
+
+struct Scratch {
+  std::vector<uint8_t> inRoom;
+  std::vector<int> dist;
+  std::vector<int> queue;
+};
+
+struct WorkerResult {
+  std::vector<uint32_t> genNanos;
+  std::vector<FloorStats> matches;
+  long long matched;
+  long long sumRooms;
+  long long sumCorridor;
+  long long sumExit;
+  int unreachable;
+};
+
+static int CorridorLength(const Dungeon &dungeon, Scratch &scratch) {
+  int size = dungeon.width * dungeon.height;
+  scratch.inRoom.assign(size, 0);
+  for (const auto &room : dungeon.rooms) {
+    for (int y = room.y; y < room.y + room.h; y++) {
+      for (int x = room.x; x < room.x + room.w; x++) {
+        scratch.inRoom[TileIndex(dungeon, x, y)] = 1;
+      }
+    }
+  }
+  int length = 0;
+  for (int y = 0; y < dungeon.height; y++) {
+    for (int x = 0; x < dungeon.width; x++) {
+      int idx = TileIndex(dungeon, x, y);
+      if (IsWalkable(dungeon, x, y) && !scratch.inRoom[idx]) length++;
+    }
+  }
+  return length;
+}
+
+static int ExitDistance(const Dungeon &dungeon, Scratch &scratch) {
+  GridPos start = dungeon.rooms.front().Center();
+  scratch.dist.assign(dungeon.width * dungeon.height, -1);
+  scratch.queue.clear();
+  int startIdx = TileIndex(dungeon, start.x, start.y);
+  scratch.dist[startIdx] = 0;
+  scratch.queue.push_back(startIdx);
+  static const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (size_t head = 0; head < scratch.queue.size(); head++) {
+    int idx = scratch.queue[head];
+    int x = idx % dungeon.width;
+    int y = idx / dungeon.width;
+    if (x == dungeon.exit.x && y == dungeon.exit.y) return scratch.dist[idx];
+    for (const auto &dir : dirs) {
+      int nx = x + dir[0];
+      int ny = y + dir[1];
+      if (!IsWalkable(dungeon, nx, ny)) continue;
+      int next = TileIndex(dungeon, nx, ny);
+      if (scratch.dist[next] >= 0) continue;
+      scratch.dist[next] = scratch.dist[idx] + 1;
+      scratch.queue.push_back(next);
+    }
+  }
+  return -1;
+}
+
+static bool Matches(const ScanConfig &config, const FloorStats &stats) {
+  if (stats.rooms < config.minRooms || stats.rooms > config.maxRooms) {
+    return false;
+  }
+  if (stats.exitDistance < config.minExit) return false;
+  if (config.maxExit >= 0 && stats.exitDistance > config.maxExit) return false;
+  if (config.maxCorridor >= 0 && stats.corridor > config.maxCorridor) {
+    return false;
+  }
+  return true;
+}
+
+static void ScanWorker(const ScanConfig &config, std::atomic<long long> &next,
+                       WorkerResult &result) {
+  const long long chunk = 4096;
+  Scratch scratch;
+  result = WorkerResult{};
+  while (true) {
+    long long begin = next.fetch_add(chunk);
+    if (begin >= config.count) break;
+    long long end = std::min(config.count, begin + chunk);
+    for (long long i = begin; i < end; i++) {
+      int seed = (int)(config.firstSeed + i);
+      auto t0 = std::chrono::steady_clock::now();
+      Dungeon dungeon =
+          GenerateDungeon(config.width, config.height, seed, config.mode);
+      auto t1 = std::chrono::steady_clock::now();
+      result.genNanos.push_back((uint32_t)std::chrono::duration_cast<
+                                    std::chrono::nanoseconds>(t1 - t0)
+                                    .count());
+
+      FloorStats stats;
+      stats.seed = seed;
+      stats.rooms = (int)dungeon.rooms.size();
+      stats.corridor = CorridorLength(dungeon, scratch);
+      stats.exitDistance = ExitDistance(dungeon, scratch);
+      if (stats.exitDistance < 0) result.unreachable++;
+      result.sumRooms += stats.rooms;
+      result.sumCorridor += stats.corridor;
+      result.sumExit += std::max(0, stats.exitDistance);
+      if (!Matches(config, stats)) continue;
+      result.matched++;
+      if ((int)result.matches.size() < config.printLimit) {
+        result.matches.push_back(stats);
+      }
+    }
+  }
+}
+
+static uint32_t Percentile(const std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t idx = (size_t)(p * (sorted.size() - 1));
+  return sorted[idx];
+}
+
+static double RunScan(const ScanConfig &config) {
+  std::atomic<long long> next{0};
+  std::vector<WorkerResult> results(config.threads);
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < config.threads; t++) {
+    workers.emplace_back(ScanWorker, std::cref(config), std::ref(next),
+                         std::ref(results[t]));
+  }
+  for (auto &worker : workers) worker.join();
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::vector<uint32_t> nanos;
+  std::vector<FloorStats> matches;
+  long long matched = 0;
+  long long sumRooms = 0;
+  long long sumCorridor = 0;
+  long long sumExit = 0;
+  int unreachable = 0;
+  for (auto &result : results) {
+    nanos.insert(nanos.end(), result.genNanos.begin(), result.genNanos.end());
+    matches.insert(matches.end(), result.matches.begin(),
+                   result.matches.end());
+    matched += result.matched;
+    sumRooms += result.sumRooms;
+    sumCorridor += result.sumCorridor;
+    sumExit += result.sumExit;
+    unreachable += result.unreachable;
+  }
+  std::sort(nanos.begin(), nanos.end());
+  std::sort(matches.begin(), matches.end(),
+            [](const FloorStats &a, const FloorStats &b) {
+              return a.seed < b.seed;
+            });
+  if ((int)matches.size() > config.printLimit) {
+    matches.resize(config.printLimit);
+  }
+
+  for (const auto &stats : matches) {
+    std::printf("seed %d rooms %d corridor %d exit %d\n", stats.seed,
+                stats.rooms, stats.corridor, stats.exitDistance);
+  }
+
+  double count = (double)config.count;
+  GenerateMode mode =
+      ResolveGenerateMode(config.mode, config.width, config.height);
+  std::fprintf(stderr, "floors       %lld (%dx%d, %s) on %d threads\n",
+               config.count, config.width, config.height,
+               GenerateModeName(mode), config.threads);
+  std::fprintf(stderr, "matched      %lld\n", matched);
+  std::fprintf(stderr, "unreachable  %d\n", unreachable);
+  std::fprintf(stderr, "avg rooms    %.2f\n", sumRooms / count);
+  std::fprintf(stderr, "avg corridor %.2f\n", sumCorridor / count);
+  std::fprintf(stderr, "avg exit     %.2f\n", sumExit / count);
+  std::fprintf(stderr, "gen ns       p50 %u p90 %u p99 %u max %u\n",
+               Percentile(nanos, 0.50), Percentile(nanos, 0.90),
+               Percentile(nanos, 0.99), nanos.empty() ? 0 : nanos.back());
+  std::fprintf(stderr, "throughput   %.0f floors/s\n", count / seconds);
+  return count / seconds;
+}
+
+static void Usage(const char *name) {
+  std::fprintf(stderr,
+               "usage: %s [--from SEED] [--count N] [--threads N]\n"
+               "          [--size WxH] [--min-rooms N] [--max-rooms N]\n"
+               "          [--min-exit N] [--max-exit N] [--max-corridor N]\n"
+               "          [--print N]\n"
+               "          [--mode auto|scattered|partitioned|compare]\n",
+               name);
+}
+
+int main(int argc, char **argv) {
+  ScanConfig config;
+  config.width = 32;
+  config.height = 24;
+  config.firstSeed = 1;
+  config.count = 100000;
+  config.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  config.minRooms = 0;
+  config.maxRooms = 1 << 30;
+  config.minExit = 0;
+  config.maxExit = -1;
+  config.maxCorridor = -1;
+  config.printLimit = 20;
+  config.mode = GenerateMode::Auto;
+  config.compare = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) {
+      Usage(argv[0]);
+      return 1;
+    }
+    i++;
+    if (std::strcmp(arg, "--from") == 0) {
+      config.firstSeed = std::atoll(value);
+    } else if (std::strcmp(arg, "--count") == 0) {
+      config.count = std::atoll(value);
+    } else if (std::strcmp(arg, "--threads") == 0) {
+      config.threads = std::max(1, std::atoi(value));
+    } else if (std::strcmp(arg, "--size") == 0) {
+      if (std::sscanf(value, "%dx%d", &config.width, &config.height) != 2) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else if (std::strcmp(arg, "--min-rooms") == 0) {
+      config.minRooms = std::atoi(value);
+    } else if (std::strcmp(arg, "--max-rooms") == 0) {
+      config.maxRooms = std::atoi(value);
+    } else if (std::strcmp(arg, "--min-exit") == 0) {
+      config.minExit = std::atoi(value);
+    } else if (std::strcmp(arg, "--max-exit") == 0) {
+      config.maxExit = std::atoi(value);
+    } else if (std::strcmp(arg, "--max-corridor") == 0) {
+      config.maxCorridor = std::atoi(value);
+    } else if (std::strcmp(arg, "--print") == 0) {
+      config.printLimit = std::atoi(value);
+    } else if (std::strcmp(arg, "--mode") == 0) {
+      config.compare = std::strcmp(value, "compare") == 0;
+      if (!config.compare && !ParseGenerateMode(value, config.mode)) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (config.width < 16 || config.height < 16 || config.count <= 0 ||
+      config.printLimit < 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+  if (config.firstSeed < 0 || config.firstSeed > INT_MAX ||
+      config.count > INT_MAX - config.firstSeed + 1) {
+    std::fprintf(stderr, "seed range must stay within 0..%d\n", INT_MAX);
+    return 1;
+  }
+
+  if (!config.compare) {
+    RunScan(config);
+    return 0;
+  }
+  ScanConfig scattered = config;
+  scattered.mode = GenerateMode::Scattered;
+  ScanConfig partitioned = config;
+  partitioned.mode = GenerateMode::Partitioned;
+  double a = RunScan(scattered);
+  double b = RunScan(partitioned);
+  std::fprintf(stderr, "speedup      %.2fx partitioned over scattered\n",
+               a > 0.0 ? b / a : 0.0);
+  return 0;
+}
@@ -0,0 +1,149 @@
+#include "sprites.h"
+
+#include <rlgl.h>
+
+#include <algorithm>
+
+static Color Tint(Color c, float f) {
+  return Color{(unsigned char)std::min(255.0f, c.r * f),
+               (unsigned char)std::min(255.0f, c.g * f),
+               (unsigned char)std::min(255.0f, c.b * f), c.a};
+}
+
+static void DrawSprite(SpriteId id, int x, int y, int tile, int cell) {
+  int cx = x + cell / 2;
+  int cy = y + cell / 2;
+  switch (id) {
+    case SpriteId::Solid:
+      DrawRectangle(x, y, tile, tile, WHITE);
+      break;
+    case SpriteId::WallCap:
+      DrawRectangle(x, y, tile, 4, Tint(Color{120, 120, 140, 255}, 0.3f));
+      break;
+    case SpriteId::DoorA:
+    case SpriteId::DoorB: {
+      Color base = id == SpriteId::DoorA ? Color{118, 84, 44, 255}
+                                         : Color{134, 96, 52, 255};
+      DrawRectangle(x, y, tile, tile, base);
+      DrawRectangle(x + 6, y + 6, tile - 12, tile - 12, Tint(base, 1.1f));
+      DrawRectangleLines(x + 6, y + 6, tile - 12, tile - 12,
+                         Color{60, 40, 18, 220});
+      DrawCircle((int)(x + tile * 0.65f), (int)(y + tile * 0.5f), 2.0f,
+                 Color{220, 190, 100, 255});
+      break;
+    }
+    case SpriteId::ExitMark:
+      DrawRectangle(x + 6, y + 6, tile - 12, tile - 12,
+                    Color{90, 120, 160, 255});
+      break;
+    case SpriteId::Enemy0:
+    case SpriteId::Enemy1: {
+      Color c = id == SpriteId::Enemy0 ? Color{100, 180, 100, 255}
+                                       : Color{210, 200, 180, 255};
+      DrawRectangle(x + 6, y + 8, tile - 12, tile - 12, c);
+      DrawRectangleLines(x + 6, y + 8, tile - 12, tile - 12,
+                         Color{30, 20, 20, 180});
+      break;
+    }
+    case SpriteId::Gold:
+    case SpriteId::Potion: {
+      Color c = id == SpriteId::Gold ? Color{220, 190, 90, 255}
+                                     : Color{170, 80, 140, 255};
+      DrawCircle(cx, cy, 6.0f, c);
+      DrawCircleLines(cx, cy, 6.0f, Color{30, 20, 10, 200});
+      break;
+    }
+    case SpriteId::Player:
+      DrawCircle(cx, cy, 10.0f, Color{220, 230, 245, 255});
+      DrawCircleLines(cx, cy, 10.0f, Color{40, 50, 70, 220});
+      break;
+    case SpriteId::Count:
+      break;
+  }
+}
+
+static bool IsCentered(SpriteId id) {
+  return id == SpriteId::Gold || id == SpriteId::Potion ||
+         id == SpriteId::Player;
+}
+
+static void BuildPalette(Atlas &atlas) {
+  static const Color base[(int)TileColor::Count] = {
+      {44, 46, 54, 255},  {50, 52, 60, 255},  {20, 22, 28, 255},
+      {32, 34, 40, 255},  {118, 84, 44, 255}, {134, 96, 52, 255}};
+  for (int i = 0; i < (int)TileColor::Count; i++) {
+    atlas.palette[i][0] = Tint(base[i], 0.45f);
+    atlas.palette[i][1] = base[i];
+  }
+}
+
+void BuildAtlas(Atlas &atlas, int tileSize) {
+  const int count = (int)SpriteId::Count;
+  BuildPalette(atlas);
+  atlas.tileSize = tileSize;
+  atlas.cell = std::max(tileSize, 24);
+  atlas.target = LoadRenderTexture(atlas.cell * count, atlas.cell);
+  BeginTextureMode(atlas.target);
+  ClearBackground(BLANK);
+  for (int i = 0; i < count; i++) {
+    SpriteId id = (SpriteId)i;
+    int x = i * atlas.cell;
+    DrawSprite(id, x, 0, tileSize, atlas.cell);
+    if (IsCentered(id)) {
+      atlas.rects[i] = Rectangle{(float)x, 0.0f, (float)atlas.cell,
+                                 (float)atlas.cell};
+      float offset = (tileSize - atlas.cell) * 0.5f;
+      atlas.offsets[i] = Vector2{offset, offset};
+    } else {
+      atlas.rects[i] = Rectangle{(float)x, 0.0f, (float)tileSize,
+                                 (float)tileSize};
+      atlas.offsets[i] = Vector2{0.0f, 0.0f};
+    }
+  }
+  EndTextureMode();
+}
+
+void UnloadAtlas(Atlas &atlas) {
+  if (atlas.target.id != 0) UnloadRenderTexture(atlas.target);
+  atlas.target = RenderTexture2D{};
+}
+
+void BeginSprites(const Atlas &atlas, RenderStats &stats) {
+  rlSetTexture(atlas.target.texture.id);
+  stats.drawCalls++;
+}
+
+void PushSprite(const Atlas &atlas, RenderStats &stats, SpriteId id, float x,
+                float y, Color tint) {
+  const Rectangle &src = atlas.rects[(int)id];
+  const Vector2 &offset = atlas.offsets[(int)id];
+  float texW = (float)atlas.target.texture.width;
+  float texH = (float)atlas.target.texture.height;
+  float u0 = src.x / texW;
+  float u1 = (src.x + src.width) / texW;
+  float v0 = 1.0f - src.y / texH;
+  float v1 = 1.0f - (src.y + src.height) / texH;
+  float x0 = x + offset.x;
+  float y0 = y + offset.y;
+  float x1 = x0 + src.width;
+  float y1 = y0 + src.height;
+
+  if (rlCheckRenderBatchLimit(4)) stats.drawCalls++;
+  rlBegin(RL_QUADS);
+  rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+  rlNormal3f(0.0f, 0.0f, 1.0f);
+  rlTexCoord2f(u0, v0);
+  rlVertex2f(x0, y0);
+  rlTexCoord2f(u0, v1);
+  rlVertex2f(x0, y1);
+  rlTexCoord2f(u1, v1);
+  rlVertex2f(x1, y1);
+  rlTexCoord2f(u1, v0);
+  rlVertex2f(x1, y0);
+  rlEnd();
+  stats.quads++;
+}
+
+void EndSprites() {
+  rlSetTexture(0);
+}
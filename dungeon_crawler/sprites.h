@@ -0,0 +1,44 @@
+#pragma once
+
+#include <raylib.h>
+
+enum class SpriteId {
+  Solid,
+  WallCap,
+  DoorA,
+  DoorB,
+  ExitMark,
+  Enemy0,
+  Enemy1,
+  Gold,
+  Potion,
+  Player,
+  Count
+};
+
+enum class TileColor { FloorA, FloorB, WallA, WallB, DoorA, DoorB, Count };
+
+struct Atlas {
+  RenderTexture2D target;
+  int tileSize;
+  int cell;
+  Rectangle rects[(int)SpriteId::Count];
+  Vector2 offsets[(int)SpriteId::Count];
+  Color palette[(int)TileColor::Count][2];
+};
+
+struct RenderStats {
+  int drawCalls;
+  int quads;
+  int bakedTiles;
+  int chunks;
+  int hudBakes;
+  int lightUpdates;
+};
+
+void BuildAtlas(Atlas &atlas, int tileSize);
+void UnloadAtlas(Atlas &atlas);
+void BeginSprites(const Atlas &atlas, RenderStats &stats);
+void PushSprite(const Atlas &atlas, RenderStats &stats, SpriteId id, float x,
+                float y, Color tint);
+void EndSprites();
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <string>
+#include <cstdint>
 
 struct GridPos {
   int x;
@@ -11,6 +11,20 @@ inline bool operator==(GridPos a, GridPos b) {
   return a.x == b.x && a.y == b.y;
 }
 
+struct Rect {
+  float x;
+  float y;
+  float width;
+  float height;
+};
+
+struct TileRect {
+  int x;
+  int y;
+  int w;
+  int h;
+};
+
 struct Room {
   int x;
   int y;
@@ -26,7 +40,7 @@ struct Room {
   }
 };
 
-enum class TileType { Wall, Floor, Door };
+enum class TileType : uint8_t { Wall, Floor, Door };
 enum class ItemType { Potion, Gold };
 enum class GameMode { Title, Playing, GameOver };
 
@@ -46,20 +60,9 @@ struct Player {
   int defense;
 };
 
-struct Enemy {
-  Actor actor;
-  int hp;
-  int type;
-};
-
 struct Item {
   GridPos cell;
   ItemType type;
   int amount;
   bool picked;
 };
-
-struct LogLine {
-  std::string text;
-  float ttl;
-};
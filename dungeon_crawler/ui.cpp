@@ -1,9 +1,13 @@
 #include "ui.h"
 
+#include "profiler.h"
+
 #include <raylib.h>
+#include <rlgl.h>
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 static void DrawOutlinedText(const char *text, int x, int y, int size,
                              Color color) {
@@ -79,26 +83,25 @@ static void DrawCoin(int x, int y, int radius) {
 }
 
 static void DrawLogOverlay(const Game &game, Rectangle rec) {
-  if (game.log.empty()) return;
+  int lines = ActiveLogLines(game.log, 2);
+  if (lines == 0) return;
   DrawRectangleGradientV((int)rec.x, (int)rec.y, (int)rec.width,
                          (int)rec.height, Color{18, 16, 24, 200},
                          Color{10, 8, 16, 200});
   DrawRectangleLinesEx(rec, 2.0f, Color{60, 52, 78, 220});
   DrawRivets(rec, 24);
 
-  int maxLines = 2;
-  int start = 0;
-  if ((int)game.log.size() > maxLines) start = game.log.size() - maxLines;
+  char text[96];
   int lineY = (int)rec.y + 10;
-  for (int i = start; i < (int)game.log.size(); i++) {
-    DrawOutlinedText(game.log[i].text.c_str(), (int)rec.x + 12, lineY, 16,
+  for (int i = lines - 1; i >= 0; i--) {
+    FormatLog(LogLine(game.log, i), text, (int)sizeof(text));
+    DrawOutlinedText(text, (int)rec.x + 12, lineY, 16,
                      Color{210, 210, 220, 255});
     lineY += 20;
   }
 }
 
-void DrawUI(const Game &game) {
-  Rectangle bar = game.uiRect;
+static void DrawHud(const Game &game, Rectangle bar) {
   DrawRectangleGradientV((int)bar.x, (int)bar.y, (int)bar.width,
                          (int)bar.height, Color{30, 24, 34, 220},
                          Color{20, 16, 26, 220});
@@ -180,6 +183,64 @@ void DrawUI(const Game &game) {
                      (int)centerPlate.y + 30, 16,
                      Color{200, 190, 210, 255});
   }
+}
+
+static HudKey MakeHudKey(const Game &game) {
+  HudKey key;
+  key.width = (int)game.uiRect.width;
+  key.height = (int)game.uiRect.height;
+  key.hp = game.player.hp;
+  key.maxHp = game.player.maxHp;
+  key.potions = game.player.potions;
+  key.gold = game.player.gold;
+  key.turn = game.turn;
+  key.floor = game.floor;
+  return key;
+}
+
+static void BakeHud(const Game &game, HudCache &hud, const HudKey &key) {
+  if (!hud.valid || hud.key.width != key.width ||
+      hud.key.height != key.height) {
+    if (hud.valid) UnloadRenderTexture(hud.target);
+    hud.target = LoadRenderTexture(key.width, key.height);
+  }
+  hud.key = key;
+  hud.valid = true;
+  BeginTextureMode(hud.target);
+  ClearBackground(BLANK);
+  rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE,
+                            RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+  BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+  DrawHud(game, Rectangle{0.0f, 0.0f, (float)key.width, (float)key.height});
+  EndBlendMode();
+  EndTextureMode();
+}
+
+void InitHud(HudCache &hud) {
+  hud = HudCache{};
+  hud.valid = false;
+}
+
+void UnloadHud(HudCache &hud) {
+  if (hud.valid) UnloadRenderTexture(hud.target);
+  hud.valid = false;
+}
+
+void DrawUI(const Game &game, HudCache &hud, RenderStats &stats) {
+  PROFILE_ZONE(Ui);
+  HudKey key = MakeHudKey(game);
+  if (key.width > 0 && key.height > 0) {
+    if (!hud.valid || std::memcmp(&key, &hud.key, sizeof(key)) != 0) {
+      BakeHud(game, hud, key);
+      stats.hudBakes++;
+    }
+    Rectangle source{0.0f, 0.0f, (float)key.width, -(float)key.height};
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(hud.target.texture, source,
+                   Vector2{game.uiRect.x, game.uiRect.y}, WHITE);
+    EndBlendMode();
+    stats.drawCalls++;
+  }
 
   float logW = std::min(420.0f, game.dungeonRect.width * 0.6f);
   Rectangle logRec{game.dungeonRect.x + 12,
@@ -1,5 +1,27 @@
 #pragma once
 
 #include "game.h"
+#include "sprites.h"
 
-void DrawUI(const Game &game);
+#include <raylib.h>
+
+struct HudKey {
+  int width;
+  int height;
+  int hp;
+  int maxHp;
+  int potions;
+  int gold;
+  int turn;
+  int floor;
+};
+
+struct HudCache {
+  RenderTexture2D target;
+  HudKey key;
+  bool valid;
+};
+
+void InitHud(HudCache &hud);
+void UnloadHud(HudCache &hud);
+void DrawUI(const Game &game, HudCache &hud, RenderStats &stats);